@@ -0,0 +1,72 @@
+// Microbenchmark: text-encoding.cpp against Poppler's UTF helpers
+// Built by scripts/build-wasm.sh with BUILD_BENCH=1; run with `node build/text-encoding-bench.js`
+#include "text-encoding.h"
+
+#include <poppler/UTF.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace pdffiller;
+
+// Keeps results observable so the loops are not optimized away
+static size_t sink = 0;
+
+template <typename Fn>
+static void run(const char* name, const std::vector<std::string>& inputs, Fn fn) {
+    constexpr int kIterations = 200;
+    size_t bytes = 0;
+    for (const auto& input : inputs) bytes += input.size();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < kIterations; ++it) {
+        for (const auto& input : inputs) {
+            sink += fn(input).size();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mbPerSecond = static_cast<double>(bytes) * kIterations / seconds / (1024 * 1024);
+    std::printf("  %-28s %10.1f MB/s\n", name, mbPerSecond);
+}
+
+// 20k strings shaped like form data
+static std::vector<std::string> makeInputs(const std::string& prototype) {
+    std::vector<std::string> inputs;
+    inputs.reserve(20000);
+    for (int i = 0; i < 20000; ++i) {
+        inputs.push_back(prototype + std::to_string(i));
+    }
+    return inputs;
+}
+
+int main() {
+    const std::vector<std::pair<const char*, std::string>> cases = {
+        {"ascii name", "applicant.address.line"},
+        {"ascii value", "1600 Pennsylvania Avenue NW, Washington, DC 20500, United States #"},
+        {"latin-1 value", "Stra\xC3\x9F" "e 12, 8001 Z\xC3\xBCrich, Schweiz \xE2\x80\x94 Geb\xC3\xA4ude #"},
+        {"cjk value", "\xE6\x9D\xB1\xE4\xBA\xAC\xE9\x83\xBD\xE5\x8D\x83\xE4\xBB\xA3\xE7\x94\xB0\xE5\x8C\xBA #"},
+    };
+
+    for (const auto& [label, prototype] : cases) {
+        std::vector<std::string> utf8 = makeInputs(prototype);
+        std::vector<std::string> pdfText, utf16;
+        for (const auto& s : utf8) {
+            pdfText.push_back(utf8ToPdfText(s));
+            utf16.push_back(utf8ToUtf16Be(s));
+        }
+
+        std::printf("%s\n", label);
+        // utf8ToPdfText is the one encoding pass setTextFieldValue makes per value;
+        // Poppler's UTF-16 conversion is what it replaced
+        run("encode: utf8ToUtf16WithBom", utf8, [](const std::string& s) { return utf8ToUtf16WithBom(s); });
+        run("encode: utf8ToPdfText", utf8, [](const std::string& s) { return utf8ToPdfText(s); });
+        run("decode pdf text: Poppler", pdfText, [](const std::string& s) { return TextStringToUtf8(s); });
+        run("decode pdf text: SIMD", pdfText, [](const std::string& s) { return pdfTextToUtf8(s); });
+        run("decode utf-16: Poppler", utf16, [](const std::string& s) { return TextStringToUtf8(s); });
+        run("decode utf-16: SIMD", utf16, [](const std::string& s) { return pdfTextToUtf8(s); });
+    }
+
+    return sink == 0;
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <memory>
 #include <cstdint>
+#include <functional>
+#include <variant>
 
 namespace pdffiller {
 
@@ -40,10 +42,118 @@ struct PdfFormField {
     std::vector<std::string> options;
 
     // For checkboxes/radios
-    std::string exportValue;   // Value when checked
+    std::string exportValue;   // Value when checked (a radio group's first button)
     bool isChecked = false;
 };
 
+// Position of one widget (visual instance) of a field
+struct WidgetRect {
+    int pageIndex = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+};
+
+// Approximate heap usage of a document's field cache (getMemoryStats())
+struct MemoryStats {
+    size_t fieldCount = 0;
+    size_t internedStrings = 0;       // Distinct names/values/options in the string arena
+    size_t stringBytes = 0;           // String data held by the arena
+    size_t stringBytesRequested = 0;  // String data interned, counting duplicates
+    size_t arenaCapacity = 0;         // Bytes allocated for arena blocks
+    size_t fieldTableBytes = 0;       // Field entries, option lists and object refs
+    size_t indexBytes = 0;            // Name lookup index and arena hash set (estimated)
+};
+
+// Attribute groups for projected field enumeration (getFormFields(attrs))
+enum FieldAttr : uint32_t {
+    FieldAttrNames    = 1 << 0,  // name, fullName
+    FieldAttrType     = 1 << 1,  // type, readOnly, required
+    FieldAttrValue    = 1 << 2,  // value, defaultValue, exportValue, isChecked
+    FieldAttrOptions  = 1 << 3,  // options
+    FieldAttrGeometry = 1 << 4,  // pageIndex, x, y, width, height
+    FieldAttrAll      = 0x1f
+};
+
+// Bits in FieldColumns::flags
+enum FieldFlag : uint8_t {
+    FieldFlagReadOnly = 1 << 0,
+    FieldFlagRequired = 1 << 1,
+    FieldFlagChecked  = 1 << 2
+};
+
+// Struct-of-arrays field table, so bindings can hand it over in a few bulk copies.
+// Columns for attribute groups that were not requested are left empty.
+struct FieldColumns {
+    // Strings per field, in this order, in FieldColumns::strings
+    static constexpr size_t kName = 0;
+    static constexpr size_t kFullName = 1;
+    static constexpr size_t kValue = 2;
+    static constexpr size_t kDefaultValue = 3;
+    static constexpr size_t kExportValue = 4;
+    static constexpr size_t kStringsPerField = 5;
+
+    uint32_t count = 0;
+    uint32_t attrs = 0;
+
+    std::vector<uint8_t> types;         // FieldType, one per field
+    std::vector<uint8_t> flags;         // FieldFlag bits, one per field
+    std::vector<int32_t> pageIndices;   // one per field
+    std::vector<double> geometry;       // x, y, width, height per field
+
+    // UTF-8 string table: string i is strings[stringOffsets[i], stringOffsets[i + 1]).
+    // The first count * kStringsPerField entries are the per-field strings; option
+    // strings follow, with field f owning entries [optionOffsets[f], optionOffsets[f + 1]).
+    std::string strings;
+    std::vector<uint32_t> stringOffsets;
+    std::vector<uint32_t> optionOffsets;
+};
+
+// Typed value for a batch update (applyFieldValues):
+//   string  - text; choice option text or export value ("" clears a choice
+//             field unless it is an option); radio export value
+//             ("Off" or "" clears a radio group, any other string is
+//             InvalidValue; checkboxes take truthy strings, as setFieldValue does)
+//   bool    - checkbox or radio state
+//   double  - text or choice, formatted as the shortest round-trip decimal
+//   strings - choice selection; more than one requires a multi-select list box
+// Construct strings as std::string: a string literal converts to bool.
+using FieldValue = std::variant<std::string, bool, double, std::vector<std::string>>;
+
+// Value tag of an entry in a packed batch (applyPackedFieldValues)
+enum class PackedValueTag : uint8_t {
+    String = 0,  // u32 length, UTF-8 bytes
+    Bool,        // u8, nonzero is true
+    Number,      // f64
+    StringList   // u32 count, then that many strings as above
+};
+
+// Outcome of one entry of a batch update (applyFieldValues)
+enum class FieldStatus : uint8_t {
+    Ok = 0,
+    NotFound,       // No field with that name
+    Ambiguous,      // Partial name shared by several fields
+    TypeMismatch,   // Field can't take that kind of value (a bool for a text field, a signature)
+    InvalidValue,   // Not a choice field's option, a non-finite number, or "Off" for a radio group that forbids it
+    Unavailable,    // Field no longer present in the document
+    NotApplied,     // Valid, but not applied because an atomic batch had failures
+    WriteFailed     // Valid, but Poppler refused the write
+};
+
+// How the document is serialized on save
+enum class SaveMode {
+    Auto = 0,     // Full rewrite if modified, otherwise copy the original bytes
+    Incremental,  // Append only changed objects and a new xref section (keeps signatures valid)
+    FullRewrite   // Re-serialize every object
+};
+
+// Reads `length` bytes starting at `offset` into `dest`; returns false on failure
+using ByteRangeReader = std::function<bool(uint64_t offset, uint8_t* dest, size_t length)>;
+
+// Receives consecutive chunks of saved output; return false to abort
+using ByteSink = std::function<bool(const uint8_t* data, size_t length)>;
+
 // Document handle
 class PdfDocument {
 public:
@@ -53,9 +163,34 @@ public:
     // Load PDF from memory buffer
     bool loadFromMemory(const uint8_t* data, size_t length, const std::string& password = "");
 
+    // Load PDF from a buffer, taking ownership of it (no copy is made)
+    bool loadFromBuffer(std::vector<uint8_t>&& data, const std::string& password = "");
+
     // Load PDF from virtual filesystem path (Emscripten FS)
+    // The file is read on demand and must not be removed while the document is open
     bool loadFromFile(const std::string& path, const std::string& password = "");
 
+    // Load PDF lazily from a byte-range reader (e.g. HTTP range requests)
+    // Only the chunks Poppler actually touches are requested from the reader
+    bool loadFromRangeReader(uint64_t length, ByteRangeReader reader, const std::string& password = "");
+
+    // Create an independent document over the same source, as originally loaded
+    // (edits made to this document are not carried over). Memory-loaded documents
+    // share their bytes with the fork instead of copying them. File-backed
+    // documents reopen their path, so after saveToFile() over the source the
+    // fork sees the saved file.
+    // Returns nullptr on failure.
+    std::unique_ptr<PdfDocument> fork() const;
+
+    // Serialize the field table (names, types, values, geometry, options, on-states)
+    // of an unmodified document into a compact blob
+    std::vector<uint8_t> compileTemplate() const;
+
+    // Attach a blob from compileTemplate() after loading the same PDF bytes, so
+    // field enumeration and lookup skip walking the AcroForm tree.
+    // Fails (leaving the document untouched) if the blob belongs to another file.
+    bool loadTemplate(const uint8_t* data, size_t length);
+
     // Get document info
     int getPageCount() const;
     std::string getTitle() const;
@@ -65,28 +200,88 @@ public:
     // Get all form fields
     std::vector<PdfFormField> getFormFields() const;
 
-    // Get field by name
+    // Get all form fields with only the FieldAttr groups in `attrs` filled in;
+    // groups nobody asked for are never read from the document
+    std::vector<PdfFormField> getFormFields(uint32_t attrs) const;
+
+    // Same as getFormFields(attrs), packed into columns
+    FieldColumns getFormFieldColumns(uint32_t attrs) const;
+
+    // Fields with a widget on one page (0-based), read from that page's widget
+    // annotations without walking the whole form; cached per page.
+    // Empty for an invalid page (see getLastError())
+    std::vector<PdfFormField> getFormFieldsForPage(int pageIndex) const;
+
+    // Get field by fully qualified name, or by partial name if only one field has it
+    // Returns nullptr if not found or ambiguous (see getLastError()). The result
+    // is owned by the document and valid until the next getFieldByName call.
     PdfFormField* getFieldByName(const std::string& name);
 
+    // Every widget of a field (radio groups and repeated fields have several);
+    // PdfFormField geometry only describes the first one
+    std::vector<WidgetRect> getFieldWidgets(const std::string& name);
+
+    // Subtree queries over fully qualified names: `prefix` itself and every
+    // field named `prefix.*` (all fields for ""), in name order. Backed by a
+    // sorted name index, so cost grows with the subtree, not the form.
+    std::vector<PdfFormField> getFieldsUnder(const std::string& prefix);
+
+    // Set fields in the subtree by name relative to `prefix` ("line1" for
+    // "prefix.line1"); keeps going after a failure and returns false if any failed
+    bool setFieldValuesUnder(const std::string& prefix,
+                             const std::vector<std::pair<std::string, std::string>>& values);
+
+    // Reset every field in the subtree to its default value
+    bool resetFieldsUnder(const std::string& prefix);
+
+    // Hit-testing in PDF points on a 0-based page, backed by a per-page grid
+    // built on first use. Fields are returned once each, in document order.
+    std::vector<PdfFormField> getFieldsAt(int pageIndex, double x, double y);
+    std::vector<PdfFormField> getFieldsInRect(int pageIndex, double x, double y, double width, double height);
+
     // Set field values
     bool setFieldValue(const std::string& name, const std::string& value);
     bool setCheckboxValue(const std::string& name, bool checked);
 
+    // Select exactly `values` in a choice field (option texts or export values);
+    // more than one requires a multi-select list box. An empty list clears it.
+    bool setChoiceValues(const std::string& name, const std::vector<std::string>& values);
+
     // Bulk set fields from JSON-like structure
     bool setFieldValues(const std::vector<std::pair<std::string, std::string>>& values);
 
+    // Batch update: all names are resolved and values validated in one pass
+    // before anything is written. Returns one status per pair, in order. With
+    // `atomic`, nothing is applied unless every pair is valid.
+    std::vector<FieldStatus> applyFieldValues(const std::vector<std::pair<std::string, FieldValue>>& values,
+                                              bool atomic = false);
+
+    // applyFieldValues over one packed buffer, so a whole batch crosses the
+    // JS boundary in a single call. Little-endian: u32 entry count, then per
+    // entry a u32-length-prefixed UTF-8 name, a PackedValueTag byte and the
+    // value. Returns no statuses (see getLastError) if the buffer is malformed.
+    std::vector<FieldStatus> applyPackedFieldValues(const uint8_t* data, size_t length, bool atomic = false);
+
     // Flatten form (make fields non-editable, embed into page content)
     bool flattenForm();
 
     // Save to memory buffer
-    std::vector<uint8_t> saveToMemory() const;
+    std::vector<uint8_t> saveToMemory(SaveMode mode = SaveMode::Auto) const;
 
-    // Save to virtual filesystem
-    bool saveToFile(const std::string& path) const;
+    // Save by streaming fixed-size chunks to `sink` as they are produced,
+    // without materializing the whole output in memory
+    bool saveToSink(const ByteSink& sink, SaveMode mode = SaveMode::Auto) const;
+
+    // Save to virtual filesystem. A file-backed document may be saved over
+    // its own source: the output goes to "<path>.tmp" and is renamed into place.
+    bool saveToFile(const std::string& path, SaveMode mode = SaveMode::Auto) const;
 
     // Render a page to PNG (for preview)
     std::vector<uint8_t> renderPageToPng(int pageIndex, double dpi = 150.0) const;
 
+    // Memory held by the field cache
+    MemoryStats getMemoryStats() const;
+
     // Get last error message
     std::string getLastError() const;
 
@@ -98,6 +293,8 @@ private:
 // Utility functions
 std::string fieldTypeToString(FieldType type);
 FieldType stringToFieldType(const std::string& str);
+std::string saveModeToString(SaveMode mode);
+SaveMode stringToSaveMode(const std::string& str);
 
 } // namespace pdffiller
 
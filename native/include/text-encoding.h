@@ -0,0 +1,29 @@
+#ifndef TEXT_ENCODING_H
+#define TEXT_ENCODING_H
+
+#include <string>
+#include <string_view>
+
+namespace pdffiller {
+
+// Encode UTF-8 as a PDF text string: PDFDocEncoding when every character is
+// representable (one byte per character), otherwise UTF-16BE with a BOM
+std::string utf8ToPdfText(std::string_view utf8);
+
+// PDFDocEncoding only; returns false (and leaves `out` unspecified) if any
+// character has no PDFDocEncoding byte, the input is not valid UTF-8, or the
+// result would start with bytes a reader takes for a byte order mark
+bool utf8ToPdfDocEncoding(std::string_view utf8, std::string& out);
+
+// UTF-16BE with a leading FE FF byte order mark; malformed UTF-8 becomes U+FFFD
+std::string utf8ToUtf16Be(std::string_view utf8);
+
+// Decode a PDF text string (UTF-16BE with BOM, or PDFDocEncoding) to UTF-8.
+// Drop-in for Poppler's TextStringToUtf8: printable ASCII is returned as-is,
+// and encodings this does not handle (other BOMs, undefined PDFDocEncoding
+// bytes) are passed to Poppler.
+std::string pdfTextToUtf8(std::string_view text);
+
+} // namespace pdffiller
+
+#endif // TEXT_ENCODING_H
@@ -3,32 +3,84 @@
 
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
+#include <algorithm>
 
 using namespace emscripten;
 using namespace pdffiller;
 
+// Copy a native buffer into a fresh JS typed array with one bulk copy
+// (slice() of a view over the WASM heap), instead of setting element by element
+template <typename T>
+static val toTypedArray(const std::vector<T>& data) {
+    return val(typed_memory_view(data.size(), data.data())).call<val>("slice");
+}
+
+static val toUint8Array(const std::vector<uint8_t>& data) {
+    return toTypedArray(data);
+}
+
 // JavaScript-friendly wrapper
 class PdfFillerJS {
 public:
     PdfFillerJS() : doc_(std::make_unique<PdfDocument>()) {}
+    explicit PdfFillerJS(std::unique_ptr<PdfDocument> doc) : doc_(std::move(doc)) {}
 
     bool loadFromArrayBuffer(const val& arrayBuffer, const std::string& password = "") {
-        // Get the ArrayBuffer data
-        unsigned int length = arrayBuffer["byteLength"].as<unsigned int>();
-        std::vector<uint8_t> data(length);
+        // Accept either an ArrayBuffer or a view onto one (Uint8Array, Node Buffer)
+        val source = val::global("ArrayBuffer").call<bool>("isView", arrayBuffer)
+            ? val::global("Uint8Array").new_(arrayBuffer["buffer"], arrayBuffer["byteOffset"], arrayBuffer["byteLength"])
+            : val::global("Uint8Array").new_(arrayBuffer);
 
-        val uint8Array = val::global("Uint8Array").new_(arrayBuffer);
-        for (unsigned int i = 0; i < length; ++i) {
-            data[i] = uint8Array[i].as<uint8_t>();
-        }
+        // Copy into the WASM heap with a single TypedArray.set() instead of
+        // one embind round-trip per byte
+        std::vector<uint8_t> data(source["length"].as<size_t>());
+        val(typed_memory_view(data.size(), data.data())).call<void>("set", source);
+
+        return doc_->loadFromBuffer(std::move(data), password);
+    }
+
+    bool loadFromRangeProvider(double length, const val& provider, const std::string& password = "") {
+        // provider(offset, length) must synchronously return a Uint8Array with at least
+        // `length` bytes, or null on failure
+        ByteRangeReader reader = [provider](uint64_t offset, uint8_t* dest, size_t length) {
+            val chunk = provider(static_cast<double>(offset), static_cast<double>(length));
+            if (chunk.isNull() || chunk.isUndefined() || chunk["length"].as<size_t>() < length) {
+                return false;
+            }
+            val(typed_memory_view(length, dest)).call<void>("set", chunk.call<val>("subarray", 0, length));
+            return true;
+        };
 
-        return doc_->loadFromMemory(data.data(), data.size(), password);
+        return doc_->loadFromRangeReader(static_cast<uint64_t>(length), std::move(reader), password);
     }
 
     bool loadFromPath(const std::string& path, const std::string& password = "") {
         return doc_->loadFromFile(path, password);
     }
 
+    val fork() const {
+        auto copy = doc_->fork();
+        if (!copy) {
+            return val::null();
+        }
+        // Ownership passes to JS; the caller must delete() the returned handle
+        return val(PdfFillerJS(std::move(copy)));
+    }
+
+    val compileTemplate() const {
+        auto data = doc_->compileTemplate();
+        if (data.empty()) {
+            return val::null();
+        }
+        return toUint8Array(data);
+    }
+
+    bool loadTemplate(const val& blob) {
+        std::vector<uint8_t> data(blob["length"].as<size_t>());
+        val(typed_memory_view(data.size(), data.data())).call<void>("set", blob);
+        return doc_->loadTemplate(data.data(), data.size());
+    }
+
     int getPageCount() const {
         return doc_->getPageCount();
     }
@@ -45,72 +97,74 @@ public:
         return doc_->hasAcroForm();
     }
 
-    val getFormFields() const {
-        auto fields = doc_->getFormFields();
+    val getFormFields(uint32_t attrs) const {
+        auto fields = doc_->getFormFields(attrs);
         val result = val::array();
 
         for (size_t i = 0; i < fields.size(); ++i) {
-            const auto& f = fields[i];
-            val field = val::object();
-
-            field.set("name", f.name);
-            field.set("fullName", f.fullName);
-            field.set("value", f.value);
-            field.set("defaultValue", f.defaultValue);
-            field.set("type", fieldTypeToString(f.type));
-            field.set("readOnly", f.readOnly);
-            field.set("required", f.required);
-            field.set("pageIndex", f.pageIndex);
-            field.set("x", f.x);
-            field.set("y", f.y);
-            field.set("width", f.width);
-            field.set("height", f.height);
-            field.set("exportValue", f.exportValue);
-            field.set("isChecked", f.isChecked);
+            result.set(i, fieldToVal(fields[i], attrs));
+        }
 
-            val options = val::array();
-            for (size_t j = 0; j < f.options.size(); ++j) {
-                options.set(j, f.options[j]);
-            }
-            field.set("options", options);
+        return result;
+    }
 
-            result.set(i, field);
-        }
+    // Columnar variant of getFormFields: a handful of typed arrays plus one UTF-8
+    // string table, regardless of field count (see FieldColumns)
+    val getFormFieldColumns(uint32_t attrs) const {
+        FieldColumns columns = doc_->getFormFieldColumns(attrs);
 
+        val result = val::object();
+        result.set("count", columns.count);
+        result.set("attrs", columns.attrs);
+        result.set("types", toTypedArray(columns.types));
+        result.set("flags", toTypedArray(columns.flags));
+        result.set("pageIndices", toTypedArray(columns.pageIndices));
+        result.set("geometry", toTypedArray(columns.geometry));
+        result.set("strings", val(typed_memory_view(columns.strings.size(),
+            reinterpret_cast<const uint8_t*>(columns.strings.data()))).call<val>("slice"));
+        result.set("stringOffsets", toTypedArray(columns.stringOffsets));
+        result.set("optionOffsets", toTypedArray(columns.optionOffsets));
         return result;
     }
 
+    val getFormFieldsForPage(int pageIndex) const {
+        return fieldsToVal(doc_->getFormFieldsForPage(pageIndex));
+    }
+
     val getFieldByName(const std::string& name) const {
         auto* field = const_cast<PdfDocument*>(doc_.get())->getFieldByName(name);
         if (!field) {
             return val::null();
         }
 
-        val result = val::object();
-        result.set("name", field->name);
-        result.set("fullName", field->fullName);
-        result.set("value", field->value);
-        result.set("defaultValue", field->defaultValue);
-        result.set("type", fieldTypeToString(field->type));
-        result.set("readOnly", field->readOnly);
-        result.set("required", field->required);
-        result.set("pageIndex", field->pageIndex);
-        result.set("x", field->x);
-        result.set("y", field->y);
-        result.set("width", field->width);
-        result.set("height", field->height);
-        result.set("exportValue", field->exportValue);
-        result.set("isChecked", field->isChecked);
-
-        val options = val::array();
-        for (size_t i = 0; i < field->options.size(); ++i) {
-            options.set(i, field->options[i]);
-        }
-        result.set("options", options);
+        return fieldToVal(*field, FieldAttrAll);
+    }
+
+    val getFieldWidgets(const std::string& name) {
+        auto widgets = doc_->getFieldWidgets(name);
+        val result = val::array();
+
+        for (size_t i = 0; i < widgets.size(); ++i) {
+            val widget = val::object();
+            widget.set("pageIndex", widgets[i].pageIndex);
+            widget.set("x", widgets[i].x);
+            widget.set("y", widgets[i].y);
+            widget.set("width", widgets[i].width);
+            widget.set("height", widgets[i].height);
+            result.set(i, widget);
+        }
 
         return result;
     }
 
+    val getFieldsAt(int pageIndex, double x, double y) {
+        return fieldsToVal(doc_->getFieldsAt(pageIndex, x, y));
+    }
+
+    val getFieldsInRect(int pageIndex, double x, double y, double width, double height) {
+        return fieldsToVal(doc_->getFieldsInRect(pageIndex, x, y, width, height));
+    }
+
     bool setFieldValue(const std::string& name, const std::string& value) {
         return doc_->setFieldValue(name, value);
     }
@@ -119,41 +173,64 @@ public:
         return doc_->setCheckboxValue(name, checked);
     }
 
+    bool setChoiceValues(const std::string& name, const val& values) {
+        return doc_->setChoiceValues(name, vecFromJSArray<std::string>(values));
+    }
+
     bool setFieldValues(const val& values) {
-        std::vector<std::pair<std::string, std::string>> pairs;
+        auto statuses = doc_->applyFieldValues(toFieldValues(values));
+        return std::all_of(statuses.begin(), statuses.end(),
+                           [](FieldStatus status) { return status == FieldStatus::Ok; });
+    }
 
-        val keys = val::global("Object").call<val>("keys", values);
-        unsigned int length = keys["length"].as<unsigned int>();
+    // One FieldStatus code per key of `values`, in Object.keys order
+    val applyFieldValues(const val& values, bool atomic) {
+        return toStatusCodes(doc_->applyFieldValues(toFieldValues(values), atomic));
+    }
 
-        for (unsigned int i = 0; i < length; ++i) {
-            std::string key = keys[i].as<std::string>();
-            std::string value = values[key].as<std::string>();
-            pairs.emplace_back(key, value);
-        }
+    // Same, from a packed buffer the caller wrote into the WASM heap at
+    // `address` (see PdfDocument::applyPackedFieldValues). Empty if malformed.
+    val applyPackedFieldValues(uintptr_t address, size_t length, bool atomic) {
+        const auto* data = reinterpret_cast<const uint8_t*>(address);
+        return toStatusCodes(doc_->applyPackedFieldValues(data, length, atomic));
+    }
 
-        return doc_->setFieldValues(pairs);
+    val getFieldsUnder(const std::string& prefix) {
+        return fieldsToVal(doc_->getFieldsUnder(prefix));
+    }
+
+    bool setFieldValuesUnder(const std::string& prefix, const val& values) {
+        return doc_->setFieldValuesUnder(prefix, toPairs(values));
+    }
+
+    bool resetFieldsUnder(const std::string& prefix) {
+        return doc_->resetFieldsUnder(prefix);
     }
 
     bool flattenForm() {
         return doc_->flattenForm();
     }
 
-    val saveToArrayBuffer() const {
-        auto data = doc_->saveToMemory();
+    val saveToArrayBuffer(const std::string& mode) const {
+        auto data = doc_->saveToMemory(stringToSaveMode(mode));
         if (data.empty()) {
             return val::null();
         }
 
-        val uint8Array = val::global("Uint8Array").new_(data.size());
-        for (size_t i = 0; i < data.size(); ++i) {
-            uint8Array.set(i, data[i]);
-        }
+        return toUint8Array(data)["buffer"];
+    }
 
-        return uint8Array["buffer"];
+    bool saveToSink(const val& callback, const std::string& mode) const {
+        // Each chunk is handed to JS as its own Uint8Array; returning false aborts
+        ByteSink sink = [&callback](const uint8_t* data, size_t length) {
+            val chunk = val(typed_memory_view(length, data)).call<val>("slice");
+            return !callback(chunk).isFalse();
+        };
+        return doc_->saveToSink(sink, stringToSaveMode(mode));
     }
 
-    bool saveToPath(const std::string& path) const {
-        return doc_->saveToFile(path);
+    bool saveToPath(const std::string& path, const std::string& mode) const {
+        return doc_->saveToFile(path, stringToSaveMode(mode));
     }
 
     val renderPageToPng(int pageIndex, double dpi = 150.0) const {
@@ -162,12 +239,21 @@ public:
             return val::null();
         }
 
-        val uint8Array = val::global("Uint8Array").new_(data.size());
-        for (size_t i = 0; i < data.size(); ++i) {
-            uint8Array.set(i, data[i]);
-        }
+        return toUint8Array(data);
+    }
 
-        return uint8Array;
+    val getMemoryStats() const {
+        MemoryStats stats = doc_->getMemoryStats();
+
+        val result = val::object();
+        result.set("fieldCount", static_cast<double>(stats.fieldCount));
+        result.set("internedStrings", static_cast<double>(stats.internedStrings));
+        result.set("stringBytes", static_cast<double>(stats.stringBytes));
+        result.set("stringBytesRequested", static_cast<double>(stats.stringBytesRequested));
+        result.set("arenaCapacity", static_cast<double>(stats.arenaCapacity));
+        result.set("fieldTableBytes", static_cast<double>(stats.fieldTableBytes));
+        result.set("indexBytes", static_cast<double>(stats.indexBytes));
+        return result;
     }
 
     std::string getLastError() const {
@@ -175,6 +261,107 @@ public:
     }
 
 private:
+    // Only the requested attribute groups become JS properties
+    static val fieldToVal(const PdfFormField& f, uint32_t attrs) {
+        val field = val::object();
+
+        if (attrs & FieldAttrNames) {
+            field.set("name", f.name);
+            field.set("fullName", f.fullName);
+        }
+        if (attrs & FieldAttrType) {
+            field.set("type", fieldTypeToString(f.type));
+            field.set("readOnly", f.readOnly);
+            field.set("required", f.required);
+        }
+        if (attrs & FieldAttrValue) {
+            field.set("value", f.value);
+            field.set("defaultValue", f.defaultValue);
+            field.set("exportValue", f.exportValue);
+            field.set("isChecked", f.isChecked);
+        }
+        if (attrs & FieldAttrOptions) {
+            val options = val::array();
+            for (size_t j = 0; j < f.options.size(); ++j) {
+                options.set(j, f.options[j]);
+            }
+            field.set("options", options);
+        }
+        if (attrs & FieldAttrGeometry) {
+            field.set("pageIndex", f.pageIndex);
+            field.set("x", f.x);
+            field.set("y", f.y);
+            field.set("width", f.width);
+            field.set("height", f.height);
+        }
+
+        return field;
+    }
+
+    // { name: value } object -> name/value pairs
+    static std::vector<std::pair<std::string, std::string>> toPairs(const val& values) {
+        std::vector<std::pair<std::string, std::string>> pairs;
+
+        val keys = val::global("Object").call<val>("keys", values);
+        unsigned int length = keys["length"].as<unsigned int>();
+
+        for (unsigned int i = 0; i < length; ++i) {
+            std::string key = keys[i].as<std::string>();
+            std::string value = values[key].as<std::string>();
+            pairs.emplace_back(key, value);
+        }
+
+        return pairs;
+    }
+
+    static val toStatusCodes(const std::vector<FieldStatus>& statuses) {
+        std::vector<uint8_t> codes(statuses.size());
+        for (size_t i = 0; i < statuses.size(); ++i) {
+            codes[i] = static_cast<uint8_t>(statuses[i]);
+        }
+        return toUint8Array(codes);
+    }
+
+    // { name: value } object -> typed pairs, by JS type: string, boolean,
+    // number or string array; null/undefined clear, anything else is String()ed
+    static std::vector<std::pair<std::string, FieldValue>> toFieldValues(const val& values) {
+        std::vector<std::pair<std::string, FieldValue>> pairs;
+
+        val keys = val::global("Object").call<val>("keys", values);
+        unsigned int length = keys["length"].as<unsigned int>();
+        pairs.reserve(length);
+
+        val isArray = val::global("Array")["isArray"];
+        for (unsigned int i = 0; i < length; ++i) {
+            std::string key = keys[i].as<std::string>();
+            val value = values[key];
+            if (value.isString()) {
+                pairs.emplace_back(key, FieldValue(std::in_place_type<std::string>, value.as<std::string>()));
+            } else if (value.isTrue() || value.isFalse()) {
+                pairs.emplace_back(key, FieldValue(value.isTrue()));
+            } else if (value.isNumber()) {
+                pairs.emplace_back(key, FieldValue(value.as<double>()));
+            } else if (isArray(value).as<bool>()) {
+                pairs.emplace_back(key, FieldValue(vecFromJSArray<std::string>(value)));
+            } else if (value.isNull() || value.isUndefined()) {
+                pairs.emplace_back(key, FieldValue(std::in_place_type<std::string>));
+            } else {
+                pairs.emplace_back(key, FieldValue(std::in_place_type<std::string>,
+                                                   val::global("String")(value).as<std::string>()));
+            }
+        }
+
+        return pairs;
+    }
+
+    static val fieldsToVal(const std::vector<PdfFormField>& fields) {
+        val result = val::array();
+        for (size_t i = 0; i < fields.size(); ++i) {
+            result.set(i, fieldToVal(fields[i], FieldAttrAll));
+        }
+        return result;
+    }
+
     std::unique_ptr<PdfDocument> doc_;
 };
 
@@ -183,19 +370,36 @@ EMSCRIPTEN_BINDINGS(pdf_filler) {
     class_<PdfFillerJS>("PdfFiller")
         .constructor<>()
         .function("loadFromArrayBuffer", &PdfFillerJS::loadFromArrayBuffer)
+        .function("loadFromRangeProvider", &PdfFillerJS::loadFromRangeProvider)
         .function("loadFromPath", &PdfFillerJS::loadFromPath)
+        .function("fork", &PdfFillerJS::fork)
+        .function("compileTemplate", &PdfFillerJS::compileTemplate)
+        .function("loadTemplate", &PdfFillerJS::loadTemplate)
         .function("getPageCount", &PdfFillerJS::getPageCount)
         .function("getTitle", &PdfFillerJS::getTitle)
         .function("getAuthor", &PdfFillerJS::getAuthor)
         .function("hasAcroForm", &PdfFillerJS::hasAcroForm)
         .function("getFormFields", &PdfFillerJS::getFormFields)
+        .function("getFormFieldColumns", &PdfFillerJS::getFormFieldColumns)
+        .function("getFormFieldsForPage", &PdfFillerJS::getFormFieldsForPage)
         .function("getFieldByName", &PdfFillerJS::getFieldByName)
+        .function("getFieldWidgets", &PdfFillerJS::getFieldWidgets)
+        .function("getFieldsAt", &PdfFillerJS::getFieldsAt)
+        .function("getFieldsInRect", &PdfFillerJS::getFieldsInRect)
         .function("setFieldValue", &PdfFillerJS::setFieldValue)
         .function("setCheckboxValue", &PdfFillerJS::setCheckboxValue)
+        .function("setChoiceValues", &PdfFillerJS::setChoiceValues)
         .function("setFieldValues", &PdfFillerJS::setFieldValues)
+        .function("applyFieldValues", &PdfFillerJS::applyFieldValues)
+        .function("applyPackedFieldValues", &PdfFillerJS::applyPackedFieldValues)
+        .function("getFieldsUnder", &PdfFillerJS::getFieldsUnder)
+        .function("setFieldValuesUnder", &PdfFillerJS::setFieldValuesUnder)
+        .function("resetFieldsUnder", &PdfFillerJS::resetFieldsUnder)
         .function("flattenForm", &PdfFillerJS::flattenForm)
         .function("saveToArrayBuffer", &PdfFillerJS::saveToArrayBuffer)
+        .function("saveToSink", &PdfFillerJS::saveToSink)
         .function("saveToPath", &PdfFillerJS::saveToPath)
         .function("renderPageToPng", &PdfFillerJS::renderPageToPng)
+        .function("getMemoryStats", &PdfFillerJS::getMemoryStats)
         .function("getLastError", &PdfFillerJS::getLastError);
 }
@@ -1,4 +1,5 @@
 #include "pdf-filler.h"
+#include "text-encoding.h"
 
 // Poppler core API for full form support
 #include <poppler/GlobalParams.h>
@@ -9,7 +10,9 @@
 #include <poppler/Annot.h>
 #include <poppler/Link.h>
 #include <poppler/Object.h>
+#include <poppler/XRef.h>
 #include <poppler/Stream.h>
+#include <poppler/CachedFile.h>
 #include <poppler/SplashOutputDev.h>
 #include <poppler/UTF.h>
 #include <splash/SplashBitmap.h>
@@ -17,11 +20,16 @@
 #include <png.h>
 #include <cstring>
 #include <sstream>
-#include <fstream>
 #include <algorithm>
+#include <atomic>
+#include <cstdarg>
 #include <cstdio>
+#include <cmath>
+#include <charconv>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <string_view>
 
 namespace pdffiller {
 
@@ -39,7 +47,7 @@ static void initGlobalParams() {
 static std::string gooToStd(const GooString* gs) {
     if (!gs) return "";
     // PDF text strings can be UTF-16BE with BOM - convert to UTF-8
-    return TextStringToUtf8(gs->toStr());
+    return pdfTextToUtf8(gs->toStr());
 }
 
 // Helper to get raw GooString bytes - use for field name lookups
@@ -54,14 +62,382 @@ static std::unique_ptr<GooString> stdToGoo(const std::string& s) {
     return std::make_unique<GooString>(s.c_str(), s.length());
 }
 
+// CachedFile loader that pulls byte ranges from a caller-supplied reader.
+// CachedFile requests whole chunks, so the final range may run past the end.
+class RangeReaderLoader : public CachedFileLoader {
+public:
+    RangeReaderLoader(uint64_t length, ByteRangeReader reader)
+        : length_(length), reader_(std::move(reader)) {}
+
+    size_t init(CachedFile* /*cachedFile*/) override {
+        return static_cast<size_t>(length_);
+    }
+
+    int load(const std::vector<ByteRange>& ranges, CachedFileWriter* writer) override {
+        std::vector<uint8_t> buffer;
+        for (const ByteRange& range : ranges) {
+            if (range.offset >= length_) break;
+            size_t len = static_cast<size_t>(std::min<uint64_t>(range.length, length_ - range.offset));
+            buffer.resize(len);
+            if (!reader_(range.offset, buffer.data(), len)) {
+                return -1;
+            }
+            writer->write(reinterpret_cast<const char*>(buffer.data()), len);
+        }
+        return 0;
+    }
+
+private:
+    uint64_t length_;
+    ByteRangeReader reader_;
+};
+
+// vprintf-style append to a byte buffer (for the OutStream implementations below)
+static void appendFormatted(std::vector<uint8_t>& out, const char* format, va_list args) {
+    char buf[256];
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(buf, sizeof(buf), format, copy);
+    va_end(copy);
+    if (len < 0) return;
+
+    if (static_cast<size_t>(len) < sizeof(buf)) {
+        out.insert(out.end(), buf, buf + len);
+        return;
+    }
+
+    // Longer than the stack buffer - format again straight into the output
+    size_t pos = out.size();
+    out.resize(pos + len + 1);
+    vsnprintf(reinterpret_cast<char*>(out.data() + pos), len + 1, format, args);
+    out.pop_back();  // drop the terminating NUL
+}
+
+// OutStream that appends to a growable in-memory buffer, so saving
+// doesn't need a round-trip through the (MEM)FS
+class MemoryOutStream : public OutStream {
+public:
+    explicit MemoryOutStream(std::vector<uint8_t>& out) : out_(out) {}
+
+    void close() override {}
+
+    Goffset getPos() override {
+        return static_cast<Goffset>(out_.size());
+    }
+
+    void put(char c) override {
+        out_.push_back(static_cast<uint8_t>(c));
+    }
+
+    void printf(const char* format, ...) override {
+        va_list args;
+        va_start(args, format);
+        appendFormatted(out_, format, args);
+        va_end(args);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+// OutStream that buffers output into fixed-size chunks and hands each one to
+// a sink as soon as it fills up. Once the sink rejects a chunk the rest of
+// the output is discarded (Poppler's writer can't be interrupted).
+class SinkOutStream : public OutStream {
+public:
+    static constexpr size_t kChunkSize = 1024 * 1024;
+
+    explicit SinkOutStream(const ByteSink& sink) : sink_(sink) {
+        buffer_.reserve(kChunkSize);
+    }
+
+    void close() override {
+        flush();
+    }
+
+    Goffset getPos() override {
+        return static_cast<Goffset>(flushed_ + buffer_.size());
+    }
+
+    void put(char c) override {
+        buffer_.push_back(static_cast<uint8_t>(c));
+        if (buffer_.size() >= kChunkSize) flush();
+    }
+
+    void printf(const char* format, ...) override {
+        va_list args;
+        va_start(args, format);
+        appendFormatted(buffer_, format, args);
+        va_end(args);
+        if (buffer_.size() >= kChunkSize) flush();
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    void flush() {
+        if (buffer_.empty()) return;
+        if (!failed_ && !sink_(buffer_.data(), buffer_.size())) {
+            failed_ = true;
+        }
+        flushed_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    const ByteSink& sink_;
+    std::vector<uint8_t> buffer_;
+    size_t flushed_ = 0;
+    bool failed_ = false;
+};
+
+// Compiled form templates (see PdfDocument::compileTemplate) are a flat
+// host-endian (little-endian on WASM) record stream:
+//   magic "PDFT", u32 version, source fingerprint, u32 field count, fields...
+static constexpr char kTemplateMagic[4] = {'P', 'D', 'F', 'T'};
+static constexpr uint32_t kTemplateVersion = 1;
+
+class BlobWriter {
+public:
+    explicit BlobWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    template <typename T>
+    void put(T value) {
+        const auto* p = reinterpret_cast<const uint8_t*>(&value);
+        out_.insert(out_.end(), p, p + sizeof(T));
+    }
+
+    void putString(std::string_view str) {
+        put<uint32_t>(static_cast<uint32_t>(str.size()));
+        out_.insert(out_.end(), str.begin(), str.end());
+    }
+
+    void putBytes(const char* data, size_t length) {
+        out_.insert(out_.end(), data, data + length);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+class BlobReader {
+public:
+    BlobReader(const uint8_t* data, size_t length) : pos_(data), end_(data + length) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (static_cast<size_t>(end_ - pos_) < sizeof(T)) return false;
+        std::memcpy(&value, pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string& str) {
+        uint32_t length = 0;
+        if (!get(length) || static_cast<size_t>(end_ - pos_) < length) return false;
+        str.assign(reinterpret_cast<const char*>(pos_), length);
+        pos_ += length;
+        return true;
+    }
+
+    bool expectBytes(const char* data, size_t length) {
+        if (static_cast<size_t>(end_ - pos_) < length || std::memcmp(pos_, data, length) != 0) return false;
+        pos_ += length;
+        return true;
+    }
+
+    bool atEnd() const { return pos_ == end_; }
+
+private:
+    const uint8_t* pos_;
+    const uint8_t* end_;
+};
+
+// Append-only pool of distinct strings for one document's field table.
+// Equal strings share storage; views stay valid until clear() or until the
+// arena is replaced by a compacted one (see Impl::compactStrings).
+class StringArena {
+public:
+    std::string_view intern(std::string_view str) {
+        requested_ += str.size();
+        if (str.empty()) return {};
+
+        auto it = index_.find(str);
+        if (it != index_.end()) return *it;
+
+        char* dest = allocate(str.size());
+        std::memcpy(dest, str.data(), str.size());
+        std::string_view stored(dest, str.size());
+        index_.insert(stored);
+        used_ += str.size();
+        return stored;
+    }
+
+    void clear() {
+        index_.clear();
+        blocks_.clear();
+        cursor_ = nullptr;
+        remaining_ = 0;
+        used_ = requested_ = capacity_ = 0;
+    }
+
+    size_t count() const { return index_.size(); }
+    size_t bytesUsed() const { return used_; }
+    size_t bytesRequested() const { return requested_; }  // Including duplicates
+    size_t capacity() const { return capacity_; }
+
+    size_t indexBytes() const {
+        return index_.bucket_count() * sizeof(void*) +
+               index_.size() * (sizeof(std::string_view) + 2 * sizeof(void*));
+    }
+
+private:
+    static constexpr size_t kBlockSize = 16 * 1024;
+
+    char* allocate(size_t size) {
+        // Strings that would waste most of a block get one of their own
+        if (size > kBlockSize / 4) {
+            blocks_.push_back(std::make_unique<char[]>(size));
+            capacity_ += size;
+            return blocks_.back().get();
+        }
+        if (size > remaining_) {
+            blocks_.push_back(std::make_unique<char[]>(kBlockSize));
+            capacity_ += kBlockSize;
+            cursor_ = blocks_.back().get();
+            remaining_ = kBlockSize;
+        }
+        char* result = cursor_;
+        cursor_ += size;
+        remaining_ -= size;
+        return result;
+    }
+
+    std::unordered_set<std::string_view> index_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t used_ = 0;
+    size_t requested_ = 0;
+    size_t capacity_ = 0;
+};
+
+// Field table entry; strings are views into the owning document's StringArena
+struct FieldEntry {
+    std::string_view name;
+    std::string_view fullName;
+    std::string_view value;
+    std::string_view defaultValue;
+    std::string_view exportValue;
+    std::vector<std::string_view> options;
+    FieldType type = FieldType::Unknown;
+    bool readOnly = false;
+    bool required = false;
+    bool isChecked = false;
+    int pageIndex = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+};
+
+// Copy the FieldAttr groups in `attrs` out of the table
+static void copyAttributes(const FieldEntry& src, PdfFormField& dst, uint32_t attrs) {
+    if (attrs & FieldAttrNames) {
+        dst.name = src.name;
+        dst.fullName = src.fullName;
+    }
+    if (attrs & FieldAttrType) {
+        dst.type = src.type;
+        dst.readOnly = src.readOnly;
+        dst.required = src.required;
+    }
+    if (attrs & FieldAttrValue) {
+        dst.value = src.value;
+        dst.defaultValue = src.defaultValue;
+        dst.exportValue = src.exportValue;
+        dst.isChecked = src.isChecked;
+    }
+    if (attrs & FieldAttrOptions) {
+        dst.options.assign(src.options.begin(), src.options.end());
+    }
+    if (attrs & FieldAttrGeometry) {
+        dst.pageIndex = src.pageIndex;
+        dst.x = src.x;
+        dst.y = src.y;
+        dst.width = src.width;
+        dst.height = src.height;
+    }
+}
+
+static PdfFormField toFormField(const FieldEntry& entry) {
+    PdfFormField field;
+    copyAttributes(entry, field, FieldAttrAll);
+    return field;
+}
+
 class PdfDocument::Impl {
 public:
     std::unique_ptr<PDFDoc> doc_;
-    std::vector<uint8_t> originalData_;  // Keep original for incremental save
+    // Backing bytes for memory-loaded documents, shared read-only with forks
+    std::shared_ptr<const std::vector<uint8_t>> originalData_;
+    std::string sourcePath_;           // Set when file-backed
+    ByteRangeReader rangeReader_;      // Set when range-backed
+    uint64_t rangeLength_ = 0;
+    std::string password_;
     std::string lastError_;
-    std::vector<PdfFormField> cachedFields_;
-    std::unordered_map<std::string, ::FormField*> fieldMap_;  // Map from name to Poppler field
+    StringArena strings_;                       // Backs every string_view in cachedFields_, pageFields_ and fieldMap_
+    size_t compactedBytes_ = 0;                 // strings_.bytesUsed() after the last compaction
+    std::vector<FieldEntry> cachedFields_;
+    std::vector<Ref> fieldRefs_;                // Poppler object of each cachedFields_ entry
+    std::vector<::FormField*> formFields_;      // Poppler field of each entry (adopted tables: one field-tree walk on first use)
+    std::unordered_map<std::string_view, size_t> fieldMap_;  // Fully qualified and partial names -> cachedFields_ index
+    // Option lookup for one choice field, built on first use and shared by
+    // enumeration (FieldAttrOptions) and the setters
+    struct OptionIndex {
+        std::vector<std::string_view> texts;                // Display text of each option
+        std::unordered_map<std::string_view, int> byValue;  // Text or export value -> Poppler option index
+    };
+    std::unordered_map<size_t, OptionIndex> optionIndex_;  // Keyed by cachedFields_ index
+    // On-states of one checkbox or radio group, built on first use so that
+    // selecting a button by export value never scans its siblings
+    struct ButtonStates {
+        std::unordered_set<std::string_view> exportValues;  // Distinct on-state names
+        std::string_view first;                            // On-state of the first widget that has one
+    };
+    std::unordered_map<size_t, ButtonStates> buttonStates_;  // Keyed by cachedFields_ index
+    std::vector<uint32_t> nameOrder_;           // cachedFields_ indices sorted by fullName, built on first prefix query
+    bool nameOrderBuilt_ = false;
+    PdfFormField lookupResult_;                 // Returned by getFieldByName
+    std::vector<bool> fieldDirty_;              // Entry changed since it was last read from Poppler
+    std::vector<size_t> dirtyFields_;           // Indices with fieldDirty_ set
     bool fieldsCached_ = false;
+    bool fieldsResolved_ = false;               // Every formFields_ entry looked up (always true for walked tables)
+    uint32_t loadedAttrs_ = 0;  // FieldAttr groups populated in cachedFields_
+
+    // Fields with a widget on one page, built from that page's Annots
+    // independently of the document-wide table
+    struct PageFields {
+        bool cached = false;
+        std::vector<FieldEntry> fields;
+    };
+    std::vector<PageFields> pageFields_;        // Indexed by 0-based page
+
+    // Every widget of every cachedFields_ entry, grouped by page, with a
+    // uniform grid over each page built on the first hit-test against it
+    struct WidgetBox {
+        uint32_t field;              // cachedFields_ index
+        double x1, y1, x2, y2;       // Normalized (x1 <= x2, y1 <= y2)
+    };
+    struct PageWidgets {
+        std::vector<WidgetBox> boxes;
+        bool indexed = false;
+        double originX = 0, originY = 0, cellWidth = 1, cellHeight = 1;
+        int cols = 0, rows = 0;
+        std::vector<uint32_t> cellStart;   // cols * rows + 1 offsets into cellBoxes
+        std::vector<uint32_t> cellBoxes;   // boxes indices, grouped by cell
+    };
+    std::vector<PageWidgets> pageWidgets_;      // Indexed by 0-based page
+    bool widgetsCached_ = false;
     bool modified_ = false;
 
     Impl() {
@@ -71,52 +447,133 @@ public:
     ~Impl() = default;
 
     bool loadFromMemory(const uint8_t* data, size_t length, const std::string& password) {
-        // Store original data for potential incremental save
-        originalData_.assign(data, data + length);
+        // Copy the caller's bytes; loadFromBuffer then adopts the copy
+        return loadFromBuffer(std::vector<uint8_t>(data, data + length), password);
+    }
 
-        // Create a MemStream from the data
-        // Note: PDFDoc takes ownership of the stream
+    bool loadFromBuffer(std::vector<uint8_t>&& data, const std::string& password) {
+        return loadShared(std::make_shared<const std::vector<uint8_t>>(std::move(data)), password);
+    }
+
+    bool loadShared(std::shared_ptr<const std::vector<uint8_t>> data, const std::string& password) {
+        // Drop the previous document before its backing bytes are released
+        closeDocument();
+
+        // Keep the bytes alive for the lifetime of the document (and for incremental save)
+        originalData_ = std::move(data);
+        password_ = password;
+
+        // Create a MemStream over the adopted bytes
+        // Note: PDFDoc takes ownership of the stream, not of the data
         Object obj = Object(objNull);
 
         auto* stream = new MemStream(
-            reinterpret_cast<const char*>(originalData_.data()),
+            reinterpret_cast<const char*>(originalData_->data()),
             0,
-            static_cast<Goffset>(originalData_.size()),
+            static_cast<Goffset>(originalData_->size()),
             std::move(obj)
         );
 
-        std::optional<GooString> ownerPw = password.empty() ? std::nullopt : std::optional<GooString>(password);
-        std::optional<GooString> userPw = password.empty() ? std::nullopt : std::optional<GooString>(password);
+        doc_ = std::make_unique<PDFDoc>(stream, toPassword(password), toPassword(password));
+        return finishLoad();
+    }
 
-        doc_ = std::make_unique<PDFDoc>(stream, ownerPw, userPw);
+    bool loadFromFile(const std::string& path, const std::string& password) {
+        closeDocument();
+        sourcePath_ = path;
+        password_ = password;
 
-        if (!doc_->isOk()) {
-            lastError_ = "Failed to load PDF: error code " + std::to_string(doc_->getErrorCode());
-            doc_.reset();
+        // Let Poppler open the file itself (GooFile + FileStream) so that only the
+        // parts it actually reads - xref, catalog, AcroForm, rendered pages - are
+        // paged in, instead of slurping the whole file into memory
+        doc_ = std::make_unique<PDFDoc>(std::make_unique<GooString>(path),
+                                        toPassword(password), toPassword(password));
+
+        if (!doc_->isOk() && doc_->getErrorCode() == errOpenFile) {
+            lastError_ = "Failed to open file: " + path;
+            closeDocument();
+            return false;
+        }
+        return finishLoad();
+    }
+
+    bool loadFromRangeReader(uint64_t length, ByteRangeReader reader, const std::string& password) {
+        closeDocument();
+
+        if (!reader) {
+            lastError_ = "No range reader provided";
             return false;
         }
+        rangeReader_ = reader;
+        rangeLength_ = length;
+        password_ = password;
+
+        // CachedFile owns the loader; the stream holds the only reference to the CachedFile
+        auto* cachedFile = new CachedFile(new RangeReaderLoader(length, std::move(reader)));
+        auto* stream = new CachedFileStream(cachedFile, 0, false, cachedFile->getLength(), Object(objNull));
+
+        doc_ = std::make_unique<PDFDoc>(stream, toPassword(password), toPassword(password));
+        return finishLoad();
+    }
+
+    // Open the same source as `other`, as originally loaded. Memory-backed
+    // documents share the original bytes instead of copying them. The PDFDoc
+    // constructor still parses the xref and trailer again, eagerly; other
+    // objects are parsed when first fetched. Edits land in this document's
+    // own XRef.
+    bool loadFork(const Impl& other) {
+        if (other.originalData_) {
+            return loadShared(other.originalData_, other.password_);
+        }
+        if (!other.sourcePath_.empty()) {
+            return loadFromFile(other.sourcePath_, other.password_);
+        }
+        if (other.rangeReader_) {
+            return loadFromRangeReader(other.rangeLength_, other.rangeReader_, other.password_);
+        }
+        lastError_ = "No document loaded";
+        return false;
+    }
+
+    static std::optional<GooString> toPassword(const std::string& password) {
+        return password.empty() ? std::nullopt : std::optional<GooString>(password);
+    }
 
+    void closeDocument() {
+        doc_.reset();
+        originalData_.reset();
+        sourcePath_.clear();
+        rangeReader_ = nullptr;
+        rangeLength_ = 0;
+        password_.clear();
+        cachedFields_.clear();
+        fieldRefs_.clear();
+        formFields_.clear();
+        fieldMap_.clear();
+        fieldDirty_.clear();
+        dirtyFields_.clear();
         fieldsCached_ = false;
+        fieldsResolved_ = false;
+        loadedAttrs_ = 0;
+        nameOrder_.clear();
+        nameOrderBuilt_ = false;
+        optionIndex_.clear();
+        buttonStates_.clear();
+        pageFields_.clear();
+        pageWidgets_.clear();
+        widgetsCached_ = false;
+        strings_.clear();
+        compactedBytes_ = 0;
         modified_ = false;
-        return true;
     }
 
-    bool loadFromFile(const std::string& path, const std::string& password) {
-        // Read file into memory first
-        std::ifstream file(path, std::ios::binary | std::ios::ate);
-        if (!file) {
-            lastError_ = "Failed to open file: " + path;
+    bool finishLoad() {
+        if (!doc_->isOk()) {
+            lastError_ = "Failed to load PDF: error code " + std::to_string(doc_->getErrorCode());
+            closeDocument();
             return false;
         }
-
-        size_t size = file.tellg();
-        file.seekg(0);
-        originalData_.resize(size);
-        file.read(reinterpret_cast<char*>(originalData_.data()), size);
-        file.close();
-
-        // Now load using loadFromMemory
-        return loadFromMemory(originalData_.data(), originalData_.size(), password);
+        return true;
     }
 
     Form* getForm() {
@@ -126,42 +583,167 @@ public:
         return catalog->getForm();
     }
 
-    ::FormField* findFormField(const std::string& name) {
-        // Ensure fields are cached (this also populates fieldMap_)
+    static constexpr size_t kFieldNotFound = static_cast<size_t>(-1);
+    static constexpr size_t kFieldAmbiguous = static_cast<size_t>(-2);
+
+    // Resolve a fully qualified name, or a partial name that identifies a
+    // single field, to its cachedFields_ index. Sets lastError_ on failure.
+    size_t lookupField(const std::string& name) {
         cacheFormFields();
 
-        // Look up by fullName first, then by name
         auto it = fieldMap_.find(name);
-        if (it != fieldMap_.end()) {
-            return it->second;
+        if (it == fieldMap_.end()) {
+            lastError_ = "Field not found: " + name;
+            return kFieldNotFound;
         }
+        if (it->second == kFieldAmbiguous) {
+            lastError_ = "Ambiguous field name: " + name + " (use the fully qualified name)";
+            return kFieldAmbiguous;
+        }
+        return it->second;
+    }
 
-        return nullptr;
+    static bool isValidIndex(size_t index) {
+        return index != kFieldNotFound && index != kFieldAmbiguous;
+    }
+
+    ::FormField* resolveField(size_t index) {
+        // Tables adopted from a compiled template or a fork resolve their
+        // Poppler fields on first use, all at once, by object reference
+        if (!formFields_[index] && !fieldsResolved_) {
+            resolveFields();
+        }
+        if (!formFields_[index]) {
+            lastError_ = "Field no longer present in document: " + fieldName(index);
+        }
+        return formFields_[index];
+    }
+
+    // Match every adopted entry to its Poppler field in one walk of the
+    // field tree (Form::findFieldByRef is a tree search per call). Poppler
+    // still builds its Form for this; what adoption saves is reading names
+    // and attributes.
+    void resolveFields() {
+        fieldsResolved_ = true;
+        Form* form = getForm();
+        if (!form) return;
+
+        auto key = [](Ref ref) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(ref.num)) << 32) | static_cast<uint32_t>(ref.gen);
+        };
+        std::unordered_map<uint64_t, size_t> byRef;
+        byRef.reserve(fieldRefs_.size());
+        for (size_t i = 0; i < fieldRefs_.size(); ++i) {
+            byRef.emplace(key(fieldRefs_[i]), i);
+        }
+
+        std::vector<::FormField*> stack;
+        for (int i = 0; i < form->getNumFields(); ++i) {
+            stack.push_back(form->getRootField(i));
+        }
+        while (!stack.empty()) {
+            ::FormField* field = stack.back();
+            stack.pop_back();
+            if (!field) continue;
+            auto it = byRef.find(key(field->getRef()));
+            if (it != byRef.end() && !formFields_[it->second]) {
+                formFields_[it->second] = field;
+            }
+            for (int i = 0; i < field->getNumChildren(); ++i) {
+                stack.push_back(field->getChildren(i));
+            }
+        }
+    }
+
+    std::string fieldName(size_t index) const {
+        return std::string(cachedFields_[index].fullName);
+    }
+
+    // Rebuild fieldMap_ from cachedFields_. Fully qualified names win over
+    // partial names; a partial name shared by several fields is marked ambiguous.
+    void indexFields() {
+        fieldMap_.clear();
+        fieldMap_.reserve(cachedFields_.size() * 2);
+        nameOrderBuilt_ = false;
+        optionIndex_.clear();
+        buttonStates_.clear();
+
+        for (size_t i = 0; i < cachedFields_.size(); ++i) {
+            if (!cachedFields_[i].fullName.empty()) {
+                fieldMap_.emplace(cachedFields_[i].fullName, i);
+            }
+        }
+
+        for (size_t i = 0; i < cachedFields_.size(); ++i) {
+            std::string_view name = cachedFields_[i].name;
+            if (name.empty() || name == cachedFields_[i].fullName) continue;
+
+            auto [it, inserted] = fieldMap_.emplace(name, i);
+            if (inserted || it->second == kFieldAmbiguous) continue;
+            if (cachedFields_[it->second].fullName != name) {
+                it->second = kFieldAmbiguous;
+            }
+        }
     }
 
     void cacheFormFields() {
         if (fieldsCached_ || !doc_) return;
         cachedFields_.clear();
+        fieldRefs_.clear();
+        formFields_.clear();
 
         Form* form = getForm();
-        if (!form) {
-            fieldsCached_ = true;
-            return;
-        }
-
-        int numFields = form->getNumFields();
-        for (int i = 0; i < numFields; ++i) {
-            ::FormField* field = form->getRootField(i);
-            if (field) {
-                collectFieldsRecursive(field, cachedFields_, fieldMap_);
+        if (form) {
+            int numFields = form->getNumFields();
+            for (int i = 0; i < numFields; ++i) {
+                ::FormField* field = form->getRootField(i);
+                if (field) {
+                    collectFieldsRecursive(field, cachedFields_);
+                }
             }
         }
 
+        indexFields();
+        fieldDirty_.assign(cachedFields_.size(), false);
+        dirtyFields_.clear();
         fieldsCached_ = true;
+        fieldsResolved_ = true;
+        loadedAttrs_ = FieldAttrNames | FieldAttrType;
     }
 
-    void collectFieldsRecursive(::FormField* field, std::vector<pdffiller::PdfFormField>& output,
-                                std::unordered_map<std::string, ::FormField*>& fieldMap) {
+    // Populate the attribute groups in `attrs` that the cache doesn't hold yet.
+    // The tree walk only collects names and types; values, options and
+    // geometry are read from Poppler the first time someone asks for them.
+    void ensureAttributes(uint32_t attrs) {
+        cacheFormFields();
+        uint32_t missing = attrs & ~loadedAttrs_;
+
+        if (missing & (FieldAttrValue | FieldAttrOptions | FieldAttrGeometry)) {
+            for (size_t i = 0; i < cachedFields_.size(); ++i) {
+                ::FormField* field = resolveField(i);
+                if (!field) continue;
+                FieldEntry& ff = cachedFields_[i];
+                if (missing & FieldAttrValue) readFieldValue(field, ff);
+                if (missing & FieldAttrOptions) {
+                    ff.options = field->getType() == formChoice
+                        ? optionIndex(i, static_cast<::FormFieldChoice*>(field)).texts
+                        : std::vector<std::string_view>();
+                }
+                if (missing & FieldAttrGeometry) readFieldGeometry(field, ff);
+            }
+        }
+        loadedAttrs_ |= missing;
+
+        // Values read just now are current; otherwise re-read what setters changed
+        if (missing & FieldAttrValue) {
+            for (size_t index : dirtyFields_) fieldDirty_[index] = false;
+            dirtyFields_.clear();
+        } else if (loadedAttrs_ & FieldAttrValue) {
+            refreshDirtyFields();
+        }
+    }
+
+    void collectFieldsRecursive(::FormField* field, std::vector<FieldEntry>& output) {
         if (!field) return;
 
         // Get widgets (visual representations) for this field
@@ -169,222 +751,1047 @@ public:
 
         // If this is a terminal field (has widgets), add it
         if (numWidgets > 0) {
-            pdffiller::PdfFormField ff;
+            output.push_back(describeField(field));
+            fieldRefs_.push_back(field->getRef());
+            formFields_.push_back(field);
+        }
+
+        // Recurse into children
+        int numChildren = field->getNumChildren();
+        for (int i = 0; i < numChildren; ++i) {
+            collectFieldsRecursive(field->getChildren(i), output);
+        }
+    }
+
+    // Names and type of a terminal field
+    FieldEntry describeField(::FormField* field) {
+        FieldEntry ff;
+
+        // Names - both use UTF-8 for consistency; partial names repeat a lot
+        // across a form, so they are interned like everything else
+        const GooString* fullName = field->getFullyQualifiedName();
+        const GooString* partialName = field->getPartialName();
+        ff.fullName = fullName ? strings_.intern(gooToStd(fullName)) : std::string_view();
+        ff.name = partialName ? strings_.intern(gooToStd(partialName)) : ff.fullName;
+
+        // Type
+        ff.type = convertFieldType(field->getType());
 
-            // Names - both use UTF-8 for consistency
-            const GooString* fullName = field->getFullyQualifiedName();
-            const GooString* partialName = field->getPartialName();
-            ff.fullName = fullName ? gooToStd(fullName) : "";
-            ff.name = partialName ? gooToStd(partialName) : ff.fullName;
+        // Flags
+        ff.readOnly = field->isReadOnly();
+        // Required flag is in the field flags (bit 2)
+
+        // Checkbox/radio/push distinction for buttons
+        if (field->getType() == formButton) {
+            ff.type = convertButtonType(static_cast<FormFieldButton*>(field)->getButtonType());
+        }
+
+        return ff;
+    }
+
+    // Fields with a widget on `pageIndex`, read from that page's widget
+    // annotations only. Geometry is that of the field's widget on this page.
+    // Returns nullptr (and sets lastError_) for an invalid page.
+    const std::vector<FieldEntry>* pageFormFields(int pageIndex) {
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return nullptr;
+        }
+        int numPages = doc_->getNumPages();
+        if (pageIndex < 0 || pageIndex >= numPages) {
+            lastError_ = "Invalid page index: " + std::to_string(pageIndex);
+            return nullptr;
+        }
+        if (pageFields_.size() != static_cast<size_t>(numPages)) {
+            pageFields_.resize(numPages);
+        }
 
-            // Store pointer in map for fast lookup later
-            if (!ff.fullName.empty()) {
-                fieldMap[ff.fullName] = field;
+        PageFields& entry = pageFields_[pageIndex];
+        if (entry.cached) {
+            return &entry.fields;
+        }
+        entry.fields.clear();
+
+        Page* page = doc_->getPage(pageIndex + 1);
+        Annots* annots = page ? page->getAnnots() : nullptr;
+        if (annots) {
+            std::unordered_set<::FormField*> seen;  // Radio groups put several widgets on one page
+            for (Annot* annot : annots->getAnnots()) {
+                if (!annot || annot->getType() != Annot::typeWidget) continue;
+                ::FormField* field = static_cast<AnnotWidget*>(annot)->getField();
+                if (!field || !seen.insert(field).second) continue;
+
+                FieldEntry ff = describeField(field);
+                readFieldValue(field, ff);
+                readFieldOptions(field, ff);
+
+                double x1, y1, x2, y2;
+                annot->getRect(&x1, &y1, &x2, &y2);
+                ff.x = x1;
+                ff.y = y1;
+                ff.width = x2 - x1;
+                ff.height = y2 - y1;
+                ff.pageIndex = pageIndex;
+
+                entry.fields.push_back(std::move(ff));
+            }
+        }
+
+        entry.cached = true;
+        return &entry.fields;
+    }
+
+    // Drop the per-page entries of every page `field` has a widget on
+    void invalidateFieldPages(::FormField* field) {
+        if (pageFields_.empty()) return;
+
+        int numWidgets = field->getNumWidgets();
+        for (int w = 0; w < numWidgets; ++w) {
+            FormWidget* widget = field->getWidget(w);
+            auto annot = widget ? widget->getWidgetAnnotation() : nullptr;
+            int page = annot ? annot->getPageNum() - 1 : -1;
+            if (page >= 0 && static_cast<size_t>(page) < pageFields_.size()) {
+                pageFields_[page].cached = false;
+            }
+        }
+    }
+
+    // Read the parts of a field that setters can change: value and checked state
+    void readFieldValue(::FormField* field, FieldEntry& ff) {
+        switch (field->getType()) {
+            case formText: {
+                // /V rather than FormFieldText::getContent(): setTextFieldValue
+                // writes /V without going through Poppler's content
+                Object value = Form::fieldLookup(field->getObj()->getDict(), "V");
+                ff.value = value.isString() ? strings_.intern(gooToStd(value.getString())) : std::string_view();
+                break;
+            }
+            case formChoice: {
+                auto* choiceField = static_cast<FormFieldChoice*>(field);
+                // Get selected value
+                const GooString* selection = choiceField->getNumSelected() > 0 ? choiceField->getSelectedChoice() : nullptr;
+                ff.value = selection ? strings_.intern(gooToStd(selection)) : std::string_view();
+                break;
+            }
+            case formButton: {
+                auto* buttonField = static_cast<FormFieldButton*>(field);
+                if (ff.type == FieldType::Checkbox) {
+                    ff.isChecked = buttonField->getState(0);  // First widget state
+                } else if (ff.type == FieldType::Radio) {
+                    // A radio group's value (/V) is the export value of its selected button
+                    const char* selected = buttonField->getAppearanceState();
+                    ff.isChecked = selected && std::strcmp(selected, "Off") != 0;
+                    ff.value = ff.isChecked ? strings_.intern(selected) : std::string_view();
+                }
+                if (ff.type == FieldType::Checkbox || ff.type == FieldType::Radio) {
+                    FormWidget* widget = buttonField->getNumWidgets() > 0 ? buttonField->getWidget(0) : nullptr;
+                    const char* onStr = widget && widget->getType() == formButton
+                                            ? static_cast<FormWidgetButton*>(widget)->getOnStr()
+                                            : nullptr;
+                    ff.exportValue = onStr ? strings_.intern(onStr) : std::string_view();
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    const OptionIndex& optionIndex(size_t index, ::FormFieldChoice* choiceField) {
+        auto [it, inserted] = optionIndex_.try_emplace(index);
+        OptionIndex& options = it->second;
+        if (!inserted) return options;
+
+        int numChoices = choiceField->getNumChoices();
+        options.texts.reserve(numChoices);
+        options.byValue.reserve(numChoices);
+        for (int c = 0; c < numChoices; ++c) {
+            const GooString* choice = choiceField->getChoice(c);
+            if (!choice) continue;
+            std::string_view text = strings_.intern(gooToStd(choice));
+            options.texts.push_back(text);
+            options.byValue.emplace(text, c);  // First of duplicate texts wins, as with a linear scan
+        }
+
+        // Export values match too, unless they collide with a display text
+        for (int c = 0; c < numChoices; ++c) {
+            const GooString* exportVal = choiceField->getExportVal(c);
+            if (exportVal) {
+                options.byValue.emplace(strings_.intern(gooToStd(exportVal)), c);
+            }
+        }
+        return options;
+    }
+
+    const ButtonStates& buttonStates(size_t index, ::FormFieldButton* button) {
+        auto [it, inserted] = buttonStates_.try_emplace(index);
+        ButtonStates& states = it->second;
+        if (!inserted) return states;
+
+        int numWidgets = button->getNumWidgets();
+        states.exportValues.reserve(numWidgets);
+        for (int i = 0; i < numWidgets; ++i) {
+            FormWidget* widget = button->getWidget(i);
+            if (!widget || widget->getType() != formButton) continue;
+            const char* onStr = static_cast<FormWidgetButton*>(widget)->getOnStr();
+            if (!onStr || !onStr[0]) continue;
+            std::string_view state = strings_.intern(onStr);
+            states.exportValues.insert(state);
+            if (states.first.empty()) states.first = state;
+        }
+        return states;
+    }
+
+    void readFieldOptions(::FormField* field, FieldEntry& ff) {
+        ff.options.clear();
+        if (field->getType() != formChoice) return;
+
+        // Reuse the option index of a field the field cache already knows
+        auto* choiceField = static_cast<FormFieldChoice*>(field);
+        auto it = fieldMap_.find(ff.fullName);
+        if (it != fieldMap_.end() && isValidIndex(it->second) && fieldRefs_[it->second] == field->getRef()) {
+            ff.options = optionIndex(it->second, choiceField).texts;
+            return;
+        }
+        int numChoices = choiceField->getNumChoices();
+        for (int c = 0; c < numChoices; ++c) {
+            const GooString* choice = choiceField->getChoice(c);
+            if (choice) {
+                ff.options.push_back(strings_.intern(gooToStd(choice)));
+            }
+        }
+    }
+
+    void readFieldGeometry(::FormField* field, FieldEntry& ff) {
+        // Get geometry from first widget
+        FormWidget* widget = field->getNumWidgets() > 0 ? field->getWidget(0) : nullptr;
+        if (widget) {
+            double x1, y1, x2, y2;
+            widget->getRect(&x1, &y1, &x2, &y2);
+            ff.x = x1;
+            ff.y = y1;
+            ff.width = x2 - x1;
+            ff.height = y2 - y1;
+            ff.pageIndex = widget->getWidgetAnnotation()->getPageNum() - 1;  // 0-based
+        }
+    }
+
+    // Indices of the fields named `prefix` or below it (`prefix.*`), in name
+    // order. Dotted names sort so that a subtree is one contiguous run of
+    // nameOrder_: O(log n) to find it plus O(k) to walk it.
+    std::vector<size_t> subtreeFields(std::string_view prefix) {
+        cacheFormFields();
+        if (!nameOrderBuilt_) {
+            nameOrder_.resize(cachedFields_.size());
+            for (size_t i = 0; i < nameOrder_.size(); ++i) {
+                nameOrder_[i] = static_cast<uint32_t>(i);
+            }
+            std::sort(nameOrder_.begin(), nameOrder_.end(), [this](uint32_t a, uint32_t b) {
+                return cachedFields_[a].fullName < cachedFields_[b].fullName;
+            });
+            nameOrderBuilt_ = true;
+        }
+
+        auto byName = [this](uint32_t index, std::string_view name) {
+            return cachedFields_[index].fullName < name;
+        };
+        std::vector<size_t> result;
+
+        // The node itself; names like "prefix-x" may sort between it and its children
+        auto it = std::lower_bound(nameOrder_.begin(), nameOrder_.end(), prefix, byName);
+        if (!prefix.empty() && it != nameOrder_.end() && cachedFields_[*it].fullName == prefix) {
+            result.push_back(*it);
+        }
+
+        std::string childPrefix(prefix);
+        if (!childPrefix.empty()) childPrefix += '.';
+        it = std::lower_bound(it, nameOrder_.end(), std::string_view(childPrefix), byName);
+        for (; it != nameOrder_.end(); ++it) {
+            std::string_view name = cachedFields_[*it].fullName;
+            if (name.compare(0, childPrefix.size(), childPrefix) != 0) break;
+            result.push_back(*it);
+        }
+        return result;
+    }
+
+    // Collect the rect of every widget (not only widget 0) into pageWidgets_
+    void cacheWidgets() {
+        if (widgetsCached_ || !doc_) return;
+        cacheFormFields();
+        pageWidgets_.assign(doc_->getNumPages(), PageWidgets());
+
+        for (size_t i = 0; i < cachedFields_.size(); ++i) {
+            ::FormField* field = resolveField(i);
+            if (!field) continue;
+
+            int numWidgets = field->getNumWidgets();
+            for (int w = 0; w < numWidgets; ++w) {
+                FormWidget* widget = field->getWidget(w);
+                auto annot = widget ? widget->getWidgetAnnotation() : nullptr;
+                int page = annot ? annot->getPageNum() - 1 : -1;
+                if (page < 0 || static_cast<size_t>(page) >= pageWidgets_.size()) continue;
+
+                double x1, y1, x2, y2;
+                widget->getRect(&x1, &y1, &x2, &y2);
+                pageWidgets_[page].boxes.push_back({static_cast<uint32_t>(i),
+                    std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)});
+            }
+        }
+        widgetsCached_ = true;
+    }
+
+    // Bucket a page's boxes into a roughly sqrt(n) x sqrt(n) grid over their
+    // bounding box; each box is listed in every cell it overlaps
+    static void buildGrid(PageWidgets& page) {
+        page.indexed = true;
+        if (page.boxes.empty()) return;
+
+        double minX = page.boxes[0].x1, minY = page.boxes[0].y1;
+        double maxX = page.boxes[0].x2, maxY = page.boxes[0].y2;
+        for (const auto& box : page.boxes) {
+            minX = std::min(minX, box.x1);
+            minY = std::min(minY, box.y1);
+            maxX = std::max(maxX, box.x2);
+            maxY = std::max(maxY, box.y2);
+        }
+
+        int side = std::clamp(static_cast<int>(std::sqrt(static_cast<double>(page.boxes.size()))), 1, 64);
+        page.cols = page.rows = side;
+        page.originX = minX;
+        page.originY = minY;
+        page.cellWidth = std::max((maxX - minX) / side, 1e-6);
+        page.cellHeight = std::max((maxY - minY) / side, 1e-6);
+
+        // Counting pass, prefix sum, then fill (compressed rows)
+        page.cellStart.assign(static_cast<size_t>(side) * side + 1, 0);
+        forEachCell(page, [&page](size_t, size_t cell) {
+            ++page.cellStart[cell + 1];
+        });
+        for (size_t c = 1; c < page.cellStart.size(); ++c) {
+            page.cellStart[c] += page.cellStart[c - 1];
+        }
+        page.cellBoxes.resize(page.cellStart.back());
+        std::vector<uint32_t> next(page.cellStart.begin(), page.cellStart.end() - 1);
+        forEachCell(page, [&page, &next](size_t box, size_t cell) {
+            page.cellBoxes[next[cell]++] = static_cast<uint32_t>(box);
+        });
+    }
+
+    // Grid cell of a coordinate, clamped in double: casting NaN, an infinity or
+    // any value outside int's range is undefined (and traps under wasm)
+    static int cellIndex(double coord, double origin, double size, int count) {
+        double cell = std::floor((coord - origin) / size);
+        if (!(cell > 0)) return 0;  // Also NaN
+        return cell < count - 1 ? static_cast<int>(cell) : count - 1;
+    }
+
+    // Clamp a coordinate range to grid cells
+    static void cellRange(double lo, double hi, double origin, double size, int count,
+                          int& first, int& last) {
+        first = cellIndex(lo, origin, size, count);
+        last = cellIndex(hi, origin, size, count);
+    }
+
+    // Call fn(box, cell) for every grid cell each box overlaps
+    template <typename Fn>
+    static void forEachCell(const PageWidgets& page, Fn fn) {
+        for (size_t b = 0; b < page.boxes.size(); ++b) {
+            const WidgetBox& box = page.boxes[b];
+            int c0, c1, r0, r1;
+            cellRange(box.x1, box.x2, page.originX, page.cellWidth, page.cols, c0, c1);
+            cellRange(box.y1, box.y2, page.originY, page.cellHeight, page.rows, r0, r1);
+            for (int r = r0; r <= r1; ++r) {
+                for (int c = c0; c <= c1; ++c) {
+                    fn(b, static_cast<size_t>(r) * page.cols + c);
+                }
+            }
+        }
+    }
+
+    // Indices of fields with a widget on `pageIndex` overlapping [x1, x2] x [y1, y2],
+    // in document order. A point query is a zero-sized rect.
+    std::vector<size_t> hitTest(int pageIndex, double x1, double y1, double x2, double y2) {
+        std::vector<size_t> hits;
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return hits;
+        }
+        if (pageIndex < 0 || pageIndex >= doc_->getNumPages()) {
+            lastError_ = "Invalid page index: " + std::to_string(pageIndex);
+            return hits;
+        }
+
+        cacheWidgets();
+        PageWidgets& page = pageWidgets_[pageIndex];
+        if (!page.indexed) buildGrid(page);
+        if (page.boxes.empty()) return hits;
+
+        if (x1 > x2) std::swap(x1, x2);
+        if (y1 > y2) std::swap(y1, y2);
+        int c0, c1, r0, r1;
+        cellRange(x1, x2, page.originX, page.cellWidth, page.cols, c0, c1);
+        cellRange(y1, y2, page.originY, page.cellHeight, page.rows, r0, r1);
+
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                size_t cell = static_cast<size_t>(r) * page.cols + c;
+                for (uint32_t k = page.cellStart[cell]; k < page.cellStart[cell + 1]; ++k) {
+                    const WidgetBox& box = page.boxes[page.cellBoxes[k]];
+                    if (box.x1 <= x2 && x1 <= box.x2 && box.y1 <= y2 && y1 <= box.y2) {
+                        hits.push_back(box.field);
+                    }
+                }
+            }
+        }
+
+        // A box spanning several cells, or a field with several widgets, hits more than once
+        std::sort(hits.begin(), hits.end());
+        hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+        return hits;
+    }
+
+    std::vector<PdfFormField> fieldsAtIndices(const std::vector<size_t>& indices) {
+        std::vector<PdfFormField> result;
+        if (indices.empty()) return result;
+
+        const auto& fields = syncedFields();
+        result.reserve(indices.size());
+        for (size_t index : indices) {
+            result.push_back(toFormField(fields[index]));
+        }
+        return result;
+    }
+
+    // Record that a setter changed entry `index`. Only dirty entries are
+    // re-read from Poppler before the table is next handed out.
+    void markFieldDirty(size_t index) {
+        modified_ = true;
+        if (formFields_[index]) {
+            invalidateFieldPages(formFields_[index]);
+        }
+        if (!fieldDirty_[index]) {
+            fieldDirty_[index] = true;
+            dirtyFields_.push_back(index);
+        }
+    }
+
+    void refreshDirtyFields() {
+        for (size_t index : dirtyFields_) {
+            if (formFields_[index]) {
+                readFieldValue(formFields_[index], cachedFields_[index]);
             }
-            if (!ff.name.empty() && ff.name != ff.fullName) {
-                fieldMap[ff.name] = field;
+            fieldDirty_[index] = false;
+        }
+        dirtyFields_.clear();
+
+        // Replaced values stay in the arena; once it holds twice what the
+        // last compaction kept, drop them. Amortized O(1) per set.
+        static constexpr size_t kMinCompactionBytes = 64 * 1024;
+        size_t used = strings_.bytesUsed();
+        if (used > 2 * compactedBytes_ && used - compactedBytes_ > kMinCompactionBytes) {
+            compactStrings();
+        }
+    }
+
+    // Re-intern the field table into a fresh arena and drop the indexes and
+    // per-page views that point into the old one (they rebuild on demand)
+    void compactStrings() {
+        StringArena fresh;
+        for (auto& f : cachedFields_) {
+            f.name = fresh.intern(f.name);
+            f.fullName = fresh.intern(f.fullName);
+            f.value = fresh.intern(f.value);
+            f.defaultValue = fresh.intern(f.defaultValue);
+            f.exportValue = fresh.intern(f.exportValue);
+            for (auto& option : f.options) {
+                option = fresh.intern(option);
             }
+        }
+        strings_ = std::move(fresh);
+        compactedBytes_ = strings_.bytesUsed();
+
+        indexFields();  // fieldMap_, name order, option and button state indexes
+        pageFields_.clear();
+    }
+
+    // Complete field table with all pending edits applied
+    std::vector<FieldEntry>& syncedFields() {
+        ensureAttributes(FieldAttrAll);
+        return cachedFields_;
+    }
+
+    FieldType convertButtonType(FormButtonType type) {
+        switch (type) {
+            case formButtonCheck: return FieldType::Checkbox;
+            case formButtonRadio: return FieldType::Radio;
+            default: return FieldType::Button;
+        }
+    }
+
+    FieldType convertFieldType(FormFieldType type) {
+        switch (type) {
+            case formText: return FieldType::Text;
+            case formButton: return FieldType::Button;
+            case formChoice: return FieldType::Choice;
+            case formSignature: return FieldType::Signature;
+            default: return FieldType::Unknown;
+        }
+    }
 
-            // Type
-            ff.type = convertFieldType(field->getType());
+    // Set entry `index` from a string, dispatching on the field type
+    bool setFieldValue(size_t index, const std::string& value) {
+        FieldValue typed(value);
+        PendingSet set;
+        if (prepareValue(index, typed, set) != FieldStatus::Ok) {
+            return false;
+        }
+        return applyPending(set);
+    }
+
+    // Restore entry `index` to its default value (/DV)
+    bool resetField(size_t index) {
+        ::FormField* field = resolveField(index);
+        if (!field) {
+            return false;
+        }
+        field->reset({});
+        markFieldDirty(index);
+        return true;
+    }
+
+    bool setTextFieldValue(size_t index, std::string_view value) {
+        ::FormField* field = resolveField(index);
+        if (!field) {
+            return false;
+        }
+
+        if (field->getType() != formText) {
+            lastError_ = "Field is not a text field: " + fieldName(index);
+            return false;
+        }
+
+        // One encoding pass and one write: PDFDocEncoding when every character
+        // fits, UTF-16BE otherwise. FormFieldText::setContentCopy only takes
+        // UTF-16BE (it prepends FE FF to anything else), so /V is set directly
+        // and readFieldValue reads it back from there.
+        Object* fieldObj = field->getObj();
+        fieldObj->dictSet("V", Object(new GooString(utf8ToPdfText(value))));
+        doc_->getXRef()->setModifiedObject(fieldObj, field->getRef());
+
+        // Skip widget appearance updates - we don't have fonts in WASM
+        // The PDF viewer will regenerate appearances when displaying
+
+        markFieldDirty(index);
+        return true;
+    }
 
-            // Flags
-            ff.readOnly = field->isReadOnly();
-            // Required flag is in the field flags (bit 2)
+    // Select exactly the options in `values` (all must exist; nothing changes otherwise)
+    bool setChoiceFieldValues(size_t index, const std::vector<std::string>& values) {
+        ::FormField* field = resolveField(index);
+        if (!field) {
+            return false;
+        }
+
+        if (field->getType() != formChoice) {
+            lastError_ = "Field is not a choice field: " + fieldName(index);
+            return false;
+        }
+
+        auto* choiceField = static_cast<::FormFieldChoice*>(field);
+        if (values.size() > 1 && !choiceField->isMultiSelect()) {
+            lastError_ = "Field does not allow multiple selections: " + fieldName(index);
+            return false;
+        }
+
+        std::vector<int> selected;
+        if (!findChoices(index, values, selected)) {
+            return false;
+        }
+        selectChoices(index, selected);
+        return true;
+    }
+
+    // Option indices of every value in `values`, or false if one is not an option
+    bool findChoices(size_t index, const std::vector<std::string>& values, std::vector<int>& out) {
+        out.reserve(values.size());
+        for (const auto& value : values) {
+            int choice = findChoice(index, value);
+            if (choice < 0) {
+                lastError_ = "Value not in choice options: " + value;
+                return false;
+            }
+            out.push_back(choice);
+        }
+        return true;
+    }
+
+    // Option index of a resolved choice field whose text or export value is `value`, or -1
+    int findChoice(size_t index, std::string_view value) {
+        const OptionIndex& options = optionIndex(index, static_cast<::FormFieldChoice*>(formFields_[index]));
+        auto it = options.byValue.find(value);
+        return it == options.byValue.end() ? -1 : it->second;
+    }
+
+    // Make option `choice` the only selection of a resolved choice field
+    // (select() adds to the selection of a multi-select list box)
+    void selectChoice(size_t index, int choice) {
+        auto* choiceField = static_cast<::FormFieldChoice*>(formFields_[index]);
+        if (choiceField->isMultiSelect()) choiceField->deselectAll();
+        choiceField->select(choice);
+
+        // Skip widget appearance updates - we don't have fonts in WASM
+
+        markFieldDirty(index);
+    }
+
+    // Replace the selection of a resolved choice field with `choices`
+    void selectChoices(size_t index, const std::vector<int>& choices) {
+        auto* choiceField = static_cast<::FormFieldChoice*>(formFields_[index]);
+        choiceField->deselectAll();
+        for (int choice : choices) {
+            choiceField->select(choice);
+        }
+        markFieldDirty(index);
+    }
+
+    // One validated entry of a batch update
+    struct PendingSet {
+        size_t index = 0;
+        FormFieldType kind = formText;
+        std::string_view text;          // Text, viewing the caller's value...
+        std::string formatted;          // ...or a formatted number
+        std::vector<int> choices;       // Choice option indices
+        bool replace = false;           // Choice: `choices` is the whole selection
+        bool checked = false;           // Button state
+        std::string_view state;         // Radio: export value of the widget to turn on
+    };
+
+    // Legacy string form of a button state
+    static bool isTruthy(std::string_view value) {
+        return !value.empty() && value != "0" && value != "false" && value != "Off";
+    }
+
+    // Shortest decimal that reads back as `value` ("42", "0.1", "1e+21")
+    static bool formatNumber(double value, std::string& out) {
+        if (!std::isfinite(value)) {
+            return false;
+        }
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        out.assign(buffer, result.ptr);
+        return true;
+    }
+
+    FieldStatus typeMismatch(size_t index, const char* expected) {
+        lastError_ = std::string("Expected ") + expected + " for field: " + fieldName(index);
+        return FieldStatus::TypeMismatch;
+    }
+
+    // Resolve and validate one name/value pair without touching the document.
+    // On failure lastError_ describes the problem.
+    FieldStatus prepareSet(const std::string& name, const FieldValue& value, PendingSet& out) {
+        size_t index = lookupField(name);
+        if (index == kFieldNotFound) return FieldStatus::NotFound;
+        if (index == kFieldAmbiguous) return FieldStatus::Ambiguous;
+        return prepareValue(index, value, out);
+    }
+
+    // Validate `value` for entry `index`, converting it to what the field
+    // type takes. `out` may view strings inside `value`.
+    FieldStatus prepareValue(size_t index, const FieldValue& value, PendingSet& out) {
+        ::FormField* field = resolveField(index);
+        if (!field) return FieldStatus::Unavailable;
+
+        out.index = index;
+        out.kind = field->getType();
+        const auto* text = std::get_if<std::string>(&value);
+        const auto* number = std::get_if<double>(&value);
+        if (number && out.kind != formButton) {
+            if (!formatNumber(*number, out.formatted)) {
+                lastError_ = "Not a finite number for field: " + fieldName(index);
+                return FieldStatus::InvalidValue;
+            }
+        }
 
-            // Get value based on type
-            switch (field->getType()) {
-                case formText: {
-                    auto* textField = static_cast<FormFieldText*>(field);
-                    const GooString* content = textField->getContent();
-                    ff.value = content ? gooToStd(content) : "";
-                    break;
+        switch (out.kind) {
+            case formText:
+                if (text) {
+                    out.text = *text;
+                } else if (!number) {
+                    return typeMismatch(index, "a string or number");
                 }
-                case formChoice: {
-                    auto* choiceField = static_cast<FormFieldChoice*>(field);
-                    // Get selected value
-                    int numSelected = choiceField->getNumSelected();
-                    if (numSelected > 0) {
-                        const GooString* selection = choiceField->getSelectedChoice();
-                        ff.value = selection ? gooToStd(selection) : "";
+                return FieldStatus::Ok;
+            case formChoice: {
+                if (const auto* list = std::get_if<std::vector<std::string>>(&value)) {
+                    auto* choiceField = static_cast<::FormFieldChoice*>(field);
+                    if (list->size() > 1 && !choiceField->isMultiSelect()) {
+                        lastError_ = "Field does not allow multiple selections: " + fieldName(index);
+                        return FieldStatus::InvalidValue;
                     }
-                    // Get all options
-                    int numChoices = choiceField->getNumChoices();
-                    for (int c = 0; c < numChoices; ++c) {
-                        const GooString* choice = choiceField->getChoice(c);
-                        if (choice) {
-                            ff.options.push_back(gooToStd(choice));
-                        }
-                    }
-                    break;
+                    out.replace = true;
+                    return findChoices(index, *list, out.choices) ? FieldStatus::Ok : FieldStatus::InvalidValue;
+                }
+                if (!text && !number) {
+                    return typeMismatch(index, "a string, number or string array");
+                }
+                std::string_view wanted = text ? std::string_view(*text) : std::string_view(out.formatted);
+                int choice = findChoice(index, wanted);
+                if (choice < 0 && wanted.empty()) {
+                    out.replace = true;  // "" (what null/undefined become) clears, unless it is an option
+                    return FieldStatus::Ok;
                 }
-                case formButton: {
-                    auto* buttonField = static_cast<FormFieldButton*>(field);
-                    FormButtonType btnType = buttonField->getButtonType();
-                    if (btnType == formButtonCheck) {
-                        ff.type = FieldType::Checkbox;
-                        ff.isChecked = buttonField->getState(0);  // First widget state
-                    } else if (btnType == formButtonRadio) {
-                        ff.type = FieldType::Radio;
-                        ff.isChecked = buttonField->getState(0);
+                if (choice < 0) {
+                    lastError_ = "Value not in choice options: " + std::string(wanted);
+                    return FieldStatus::InvalidValue;
+                }
+                out.choices.push_back(choice);
+                return FieldStatus::Ok;
+            }
+            case formButton: {
+                auto* button = static_cast<::FormFieldButton*>(field);
+                if (const auto* flag = std::get_if<bool>(&value)) {
+                    out.checked = *flag;
+                } else if (number) {
+                    out.checked = *number != 0;
+                } else if (text) {
+                    // An export value selects that button. A checkbox also takes a truthy
+                    // flag, but a radio group only takes "Off" (or "") besides its
+                    // export values, so a typo can't silently select the first button
+                    const ButtonStates& states = buttonStates(index, button);
+                    auto it = states.exportValues.find(*text);
+                    if (it != states.exportValues.end()) {
+                        out.state = *it;
+                        out.checked = true;
+                    } else if (button->getButtonType() == formButtonRadio && !text->empty() && *text != "Off") {
+                        lastError_ = "Invalid value for radio group " + fieldName(index) + ": " + std::string(*text);
+                        return FieldStatus::InvalidValue;
                     } else {
-                        ff.type = FieldType::Button;
+                        out.checked = isTruthy(*text);
                     }
-                    break;
+                } else {
+                    return typeMismatch(index, "a boolean or string");
                 }
-                case formSignature:
-                    ff.type = FieldType::Signature;
-                    break;
-                default:
-                    break;
-            }
-
-            // Get geometry from first widget
-            if (numWidgets > 0) {
-                FormWidget* widget = field->getWidget(0);
-                if (widget) {
-                    double x1, y1, x2, y2;
-                    widget->getRect(&x1, &y1, &x2, &y2);
-                    ff.x = x1;
-                    ff.y = y1;
-                    ff.width = x2 - x1;
-                    ff.height = y2 - y1;
-                    ff.pageIndex = widget->getWidgetAnnotation()->getPageNum() - 1;  // 0-based
+                if (!out.checked && button->getButtonType() == formButtonRadio && button->noToggleToOff()) {
+                    lastError_ = "Radio group can't be turned off: " + fieldName(index);
+                    return FieldStatus::InvalidValue;
                 }
+                return FieldStatus::Ok;
             }
-
-            output.push_back(std::move(ff));
-        }
-
-        // Recurse into children
-        int numChildren = field->getNumChildren();
-        for (int i = 0; i < numChildren; ++i) {
-            collectFieldsRecursive(field->getChildren(i), output, fieldMap);
+            default:
+                lastError_ = "Unsupported field type for setValue: " + fieldName(index);
+                return FieldStatus::TypeMismatch;
         }
     }
 
-    FieldType convertFieldType(FormFieldType type) {
-        switch (type) {
-            case formText: return FieldType::Text;
-            case formButton: return FieldType::Button;
-            case formChoice: return FieldType::Choice;
-            case formSignature: return FieldType::Signature;
-            default: return FieldType::Unknown;
+    // Write a validated entry; false (with lastError_ set) if Poppler refused it
+    bool applyPending(const PendingSet& set) {
+        switch (set.kind) {
+            case formText:
+                return setTextFieldValue(set.index, set.formatted.empty() ? set.text : std::string_view(set.formatted));
+            case formChoice:
+                if (set.replace) {
+                    selectChoices(set.index, set.choices);
+                } else {
+                    selectChoice(set.index, set.choices.front());
+                }
+                return true;
+            default:
+                if (!set.state.empty()) {
+                    return setButtonState(set.index, set.state);
+                }
+                return setButtonFieldValue(set.index, set.checked);
         }
     }
 
-    bool setTextFieldValue(const std::string& name, const std::string& value) {
-        ::FormField* field = findFormField(name);
-        if (!field) {
-            lastError_ = "Field not found: " + name;
-            return false;
+    // Resolve and validate every pair first, then apply the valid ones. With
+    // `atomic`, nothing is applied unless every pair is valid; since all
+    // checks happen up front there is never a partial update to undo.
+    // Applied fields are only marked dirty; the cached table catches up once,
+    // on the next read. A write Poppler refuses after validation is reported
+    // as WriteFailed for that entry only. lastError_ keeps the first failure.
+    std::vector<FieldStatus> applyFieldValues(const std::vector<std::pair<std::string, FieldValue>>& values,
+                                              bool atomic) {
+        std::vector<FieldStatus> statuses(values.size(), FieldStatus::NotApplied);
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return statuses;
         }
+        cacheFormFields();
 
-        if (field->getType() != formText) {
-            lastError_ = "Field is not a text field: " + name;
-            return false;
+        std::vector<PendingSet> pending(values.size());
+        std::string firstError;
+        for (size_t i = 0; i < values.size(); ++i) {
+            statuses[i] = prepareSet(values[i].first, values[i].second, pending[i]);
+            if (statuses[i] != FieldStatus::Ok && firstError.empty()) {
+                firstError = lastError_;
+            }
         }
 
-        auto* textField = static_cast<::FormFieldText*>(field);
-
-        // Convert UTF-8 input to PDF text string format (UTF-16BE with BOM)
-        // This is required for proper text display in PDF viewers
-        std::string pdfStr = utf8ToUtf16WithBom(value);
-        GooString gooValue(pdfStr.c_str(), pdfStr.length());
-        textField->setContentCopy(&gooValue);
+        if (atomic && !firstError.empty()) {
+            for (auto& status : statuses) {
+                if (status == FieldStatus::Ok) status = FieldStatus::NotApplied;
+            }
+            lastError_ = firstError;
+            return statuses;
+        }
 
-        // Skip widget appearance updates - we don't have fonts in WASM
-        // The PDF viewer will regenerate appearances when displaying
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (statuses[i] == FieldStatus::Ok && !applyPending(pending[i])) {
+                statuses[i] = FieldStatus::WriteFailed;
+                if (firstError.empty()) firstError = lastError_;
+            }
+        }
 
-        modified_ = true;
-        fieldsCached_ = false;  // Invalidate cache
-        return true;
+        if (!firstError.empty()) {
+            lastError_ = firstError;
+        }
+        return statuses;
     }
 
-    bool setChoiceFieldValue(const std::string& name, const std::string& value) {
-        ::FormField* field = findFormField(name);
+    bool setButtonFieldValue(size_t index, bool checked) {
+        ::FormField* field = resolveField(index);
         if (!field) {
-            lastError_ = "Field not found: " + name;
             return false;
         }
 
-        if (field->getType() != formChoice) {
-            lastError_ = "Field is not a choice field: " + name;
+        if (field->getType() != formButton) {
+            lastError_ = "Field is not a button field: " + fieldName(index);
             return false;
         }
 
-        auto* choiceField = static_cast<::FormFieldChoice*>(field);
+        auto* buttonField = static_cast<::FormFieldButton*>(field);
+        FormButtonType btnType = buttonField->getButtonType();
 
-        // Find the index of the value
-        int numChoices = choiceField->getNumChoices();
-        int selectedIdx = -1;
-        for (int i = 0; i < numChoices; ++i) {
-            const GooString* choice = choiceField->getChoice(i);
-            if (choice && gooToStd(choice) == value) {
-                selectedIdx = i;
-                break;
-            }
+        if (btnType != formButtonCheck && btnType != formButtonRadio) {
+            // Push buttons (like hyperlinks) don't have a settable value - skip silently
+            return true;
         }
 
-        if (selectedIdx < 0) {
-            lastError_ = "Value not in choice options: " + value;
-            return false;
+        // Checked means the first button's on-state (a checkbox's only one);
+        // fall back to the common default when no widget names one
+        std::string_view checkedState = buttonStates(index, buttonField).first;
+        if (checkedState.empty()) {
+            checkedState = "Yes";
         }
+        return setButtonState(index, checked ? checkedState : std::string_view("Off"));
+    }
 
-        choiceField->select(selectedIdx);
+    // Turn on the button whose on-state is `state` ("Off" for none). Poppler
+    // walks the group's widgets once, updating /V and the /AS of the previous
+    // and new selection, so every sibling ends up consistent.
+    bool setButtonState(size_t index, std::string_view state) {
+        auto* buttonField = static_cast<::FormFieldButton*>(formFields_[index]);
+        if (!buttonField->setState(std::string(state).c_str())) {
+            lastError_ = "Radio group can't be turned off: " + fieldName(index);
+            return false;
+        }
 
         // Skip widget appearance updates - we don't have fonts in WASM
 
-        modified_ = true;
-        fieldsCached_ = false;
+        markFieldDirty(index);
         return true;
     }
 
-    bool setButtonFieldValue(const std::string& name, bool checked) {
-        ::FormField* field = findFormField(name);
-        if (!field) {
-            lastError_ = "Field not found: " + name;
+    // Identifies the source bytes a compiled template belongs to without
+    // reading them: file length, xref size and the trailer /ID pair
+    std::string sourceFingerprint() {
+        std::vector<uint8_t> bytes;
+        BlobWriter out(bytes);
+        out.put<uint64_t>(static_cast<uint64_t>(doc_->getBaseStream()->getLength()));
+        out.put<int32_t>(doc_->getXRef()->getNumObjects());
+
+        GooString permanentId, updateId;
+        if (doc_->getID(&permanentId, &updateId)) {
+            out.putString(permanentId.toStr());
+            out.putString(updateId.toStr());
+        }
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    std::vector<uint8_t> compileTemplate() {
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return {};
+        }
+        if (modified_) {
+            lastError_ = "Cannot compile a template from a modified document";
+            return {};
+        }
+        syncedFields();
+
+        std::vector<uint8_t> blob;
+        BlobWriter out(blob);
+        out.putBytes(kTemplateMagic, sizeof(kTemplateMagic));
+        out.put<uint32_t>(kTemplateVersion);
+        out.putString(sourceFingerprint());
+        out.put<uint32_t>(static_cast<uint32_t>(cachedFields_.size()));
+
+        for (size_t i = 0; i < cachedFields_.size(); ++i) {
+            const FieldEntry& f = cachedFields_[i];
+            out.put<int32_t>(fieldRefs_[i].num);
+            out.put<int32_t>(fieldRefs_[i].gen);
+            out.putString(f.name);
+            out.putString(f.fullName);
+            out.putString(f.value);
+            out.putString(f.defaultValue);
+            out.put<uint8_t>(static_cast<uint8_t>(f.type));
+            out.put<uint8_t>((f.readOnly ? 1 : 0) | (f.required ? 2 : 0) | (f.isChecked ? 4 : 0));
+            out.put<int32_t>(f.pageIndex);
+            out.put<double>(f.x);
+            out.put<double>(f.y);
+            out.put<double>(f.width);
+            out.put<double>(f.height);
+            out.put<uint32_t>(static_cast<uint32_t>(f.options.size()));
+            for (const auto& option : f.options) {
+                out.putString(option);
+            }
+            out.putString(f.exportValue);
+        }
+        return blob;
+    }
+
+    bool loadTemplate(const uint8_t* data, size_t length) {
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return false;
+        }
+        if (modified_) {
+            // The template describes the unedited document; adopting it would
+            // drop the pending edits from the field table
+            lastError_ = "Cannot load a template into a modified document";
             return false;
         }
 
-        if (field->getType() != formButton) {
-            lastError_ = "Field is not a button field: " + name;
+        BlobReader in(data, length);
+        uint32_t version = 0;
+        if (!in.expectBytes(kTemplateMagic, sizeof(kTemplateMagic)) || !in.get(version)) {
+            lastError_ = "Not a compiled form template";
+            return false;
+        }
+        if (version != kTemplateVersion) {
+            lastError_ = "Unsupported form template version: " + std::to_string(version);
             return false;
         }
 
-        auto* buttonField = static_cast<::FormFieldButton*>(field);
-        FormButtonType btnType = buttonField->getButtonType();
+        std::string fingerprint;
+        if (!in.getString(fingerprint) || fingerprint != sourceFingerprint()) {
+            lastError_ = "Form template does not match this document";
+            return false;
+        }
 
-        if (btnType != formButtonCheck && btnType != formButtonRadio) {
-            // Push buttons (like hyperlinks) don't have a settable value - skip silently
-            return true;
+        uint32_t count = 0;
+        if (!in.get(count)) {
+            lastError_ = "Truncated form template";
+            return false;
         }
 
-        // Get the "on" state name from the widget - each checkbox can have a custom name
-        const char* checkedState = nullptr;
-        int numWidgets = buttonField->getNumWidgets();
-        if (numWidgets > 0) {
-            FormWidget* widget = buttonField->getWidget(0);
-            if (widget && widget->getType() == formButton) {
-                auto* btnWidget = static_cast<FormWidgetButton*>(widget);
-                checkedState = btnWidget->getOnStr();
+        // Decode and validate everything before interning, so a bad blob
+        // leaves nothing behind in the arena
+        struct TemplateField {
+            std::string name, fullName, value, defaultValue, exportValue;
+            std::vector<std::string> options;
+            uint8_t type = 0;
+            uint8_t flags = 0;
+            FieldEntry geometry;
+        };
+        // Every record takes at least 64 bytes; don't trust `count` for the reserve
+        std::vector<TemplateField> decoded;
+        std::vector<Ref> refs;
+        decoded.reserve(std::min<size_t>(count, length / 64));
+        refs.reserve(decoded.capacity());
+
+        for (uint32_t i = 0; i < count; ++i) {
+            TemplateField& f = decoded.emplace_back();
+            Ref ref;
+            uint32_t numOptions = 0;
+            bool ok = in.get(ref.num) && in.get(ref.gen) &&
+                      in.getString(f.name) && in.getString(f.fullName) &&
+                      in.getString(f.value) && in.getString(f.defaultValue) &&
+                      in.get(f.type) && in.get(f.flags) && in.get(f.geometry.pageIndex) &&
+                      in.get(f.geometry.x) && in.get(f.geometry.y) &&
+                      in.get(f.geometry.width) && in.get(f.geometry.height) &&
+                      in.get(numOptions);
+            for (uint32_t j = 0; ok && j < numOptions; ++j) {
+                f.options.emplace_back();
+                ok = in.getString(f.options.back());
+            }
+            ok = ok && in.getString(f.exportValue);
+            if (!ok) {
+                lastError_ = "Truncated form template";
+                return false;
+            }
+            if (f.type > static_cast<uint8_t>(FieldType::Signature)) {
+                lastError_ = "Invalid field type in form template: " + std::to_string(f.type);
+                return false;
             }
+            refs.push_back(ref);
+        }
+        if (!in.atEnd()) {
+            lastError_ = "Trailing data in form template";
+            return false;
         }
 
-        // Fallback to common defaults
-        if (!checkedState || !checkedState[0]) {
-            checkedState = "Yes";
+        std::vector<FieldEntry> fields;
+        fields.reserve(count);
+        for (const TemplateField& t : decoded) {
+            FieldEntry f = t.geometry;
+            f.name = strings_.intern(t.name);
+            f.fullName = strings_.intern(t.fullName);
+            f.value = strings_.intern(t.value);
+            f.defaultValue = strings_.intern(t.defaultValue);
+            f.exportValue = strings_.intern(t.exportValue);
+            f.options.reserve(t.options.size());
+            for (const auto& option : t.options) {
+                f.options.push_back(strings_.intern(option));
+            }
+            f.type = static_cast<FieldType>(t.type);
+            f.readOnly = t.flags & 1;
+            f.required = t.flags & 2;
+            f.isChecked = t.flags & 4;
+            fields.push_back(std::move(f));
         }
 
-        // Set the state using the state name
-        const char* newState = checked ? checkedState : "Off";
-        buttonField->setState(newState);
+        adoptFieldTable(std::move(fields), std::move(refs), FieldAttrAll);
+        return true;
+    }
 
-        // Skip widget appearance updates - we don't have fonts in WASM
+    // Copy another document's field table into this document's arena
+    std::vector<FieldEntry> internFields(const std::vector<FieldEntry>& fields) {
+        std::vector<FieldEntry> result(fields);
+        for (auto& f : result) {
+            f.name = strings_.intern(f.name);
+            f.fullName = strings_.intern(f.fullName);
+            f.value = strings_.intern(f.value);
+            f.defaultValue = strings_.intern(f.defaultValue);
+            f.exportValue = strings_.intern(f.exportValue);
+            for (auto& option : f.options) {
+                option = strings_.intern(option);
+            }
+        }
+        return result;
+    }
 
-        modified_ = true;
-        fieldsCached_ = false;
-        return true;
+    // Install a prebuilt field table (strings already in strings_) carrying
+    // the attribute groups in `loadedAttrs`; Poppler fields are resolved and
+    // missing groups read on first use
+    void adoptFieldTable(std::vector<FieldEntry> fields, std::vector<Ref> refs, uint32_t loadedAttrs) {
+        cachedFields_ = std::move(fields);
+        fieldRefs_ = std::move(refs);
+        formFields_.assign(cachedFields_.size(), nullptr);
+        indexFields();
+        fieldDirty_.assign(cachedFields_.size(), false);
+        dirtyFields_.clear();
+        fieldsCached_ = true;
+        fieldsResolved_ = false;
+        loadedAttrs_ = loadedAttrs;
+
+        // Per-page views and the widget grid were built from the old table
+        pageFields_.clear();
+        pageWidgets_.clear();
+        widgetsCached_ = false;
     }
 
     bool flattenForm() {
@@ -425,46 +1832,102 @@ public:
         return true;
     }
 
-    std::vector<uint8_t> saveToMemory() {
+    PDFWriteMode writeMode(SaveMode mode) const {
+        switch (mode) {
+            case SaveMode::Incremental:
+                // Original bytes followed by the changed objects and a new xref section
+                return writeForceIncremental;
+            case SaveMode::FullRewrite:
+                return writeForceRewrite;
+            default:
+                // Auto: unmodified documents are copied through as-is
+                return modified_ ? writeForceRewrite : writeStandard;
+        }
+    }
+
+    std::vector<uint8_t> saveToMemory(SaveMode mode) {
         if (!doc_) {
             lastError_ = "No document loaded";
             return {};
         }
 
-        // Use a temp file approach since Poppler's save API is file-oriented
-        // In WASM environment, /tmp is backed by memory anyway
-        std::string tempPath = "/tmp/pdf_filler_temp_" +
-            std::to_string(reinterpret_cast<uintptr_t>(this)) + ".pdf";
-
-        // Save using GooString path
-        GooString outPath(tempPath);
-        PDFWriteMode writeMode = modified_ ? writeForceRewrite : writeStandard;
+        // Write straight into the output buffer; unmodified and incremental
+        // saves start with a copy of the original bytes, so reserve for that
+        std::vector<uint8_t> output;
+        output.reserve(static_cast<size_t>(doc_->getBaseStream()->getLength()) + 64 * 1024);
+        MemoryOutStream outStream(output);
 
-        int result = doc_->saveAs(outPath, writeMode);
+        int result = doc_->saveAs(&outStream, writeMode(mode));
         if (result != errNone) {
             lastError_ = "Failed to save PDF: error code " + std::to_string(result);
             return {};
         }
 
-        // Read back the temp file
-        std::vector<uint8_t> output;
-        std::ifstream inFile(tempPath, std::ios::binary | std::ios::ate);
-        if (!inFile) {
-            lastError_ = "Failed to read saved PDF";
-            std::remove(tempPath.c_str());
-            return {};
+        return output;
+    }
+
+    bool saveToSink(const ByteSink& sink, SaveMode mode) {
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return false;
+        }
+
+        SinkOutStream outStream(sink);
+        int result = doc_->saveAs(&outStream, writeMode(mode));
+        outStream.close();  // flush the final partial chunk
+
+        if (result != errNone) {
+            lastError_ = "Failed to save PDF: error code " + std::to_string(result);
+            return false;
+        }
+        if (outStream.failed()) {
+            lastError_ = "Save aborted by sink";
+            return false;
         }
+        return true;
+    }
 
-        size_t size = inFile.tellg();
-        inFile.seekg(0);
-        output.resize(size);
-        inFile.read(reinterpret_cast<char*>(output.data()), size);
-        inFile.close();
+    // Create an empty, previously nonexistent "<path>.tmp-N" and return its name,
+    // so that saving never clobbers an unrelated file
+    static std::string reserveTempPath(const std::string& path) {
+        static std::atomic<unsigned> counter{0};
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            std::string candidate = path + ".tmp-" + std::to_string(++counter);
+            if (FILE* file = std::fopen(candidate.c_str(), "wx")) {
+                std::fclose(file);
+                return candidate;
+            }
+        }
+        return {};
+    }
 
-        // Clean up temp file
-        std::remove(tempPath.c_str());
+    bool saveToFile(const std::string& path, SaveMode mode) {
+        if (!doc_) {
+            lastError_ = "No document loaded";
+            return false;
+        }
 
-        return output;
+        // A file-backed document still reads objects from its source while
+        // saving; opening `path` for writing could truncate that very file.
+        // Write next to it and rename over it once the output is complete.
+        const std::string target = sourcePath_.empty() ? path : reserveTempPath(path);
+        if (target.empty()) {
+            lastError_ = "Failed to create a temporary file next to: " + path;
+            return false;
+        }
+        int result = doc_->saveAs(GooString(target), writeMode(mode));
+        if (result != errNone) {
+            if (target != path) std::remove(target.c_str());
+            lastError_ = result == errOpenFile ? "Failed to open file for writing: " + target
+                                               : "Failed to save PDF: error code " + std::to_string(result);
+            return false;
+        }
+        if (target != path && std::rename(target.c_str(), path.c_str()) != 0) {
+            std::remove(target.c_str());
+            lastError_ = "Failed to replace file: " + path;
+            return false;
+        }
+        return true;
     }
 
     std::vector<uint8_t> renderPageToPng(int pageIndex, double dpi) {
@@ -550,6 +2013,38 @@ bool PdfDocument::loadFromMemory(const uint8_t* data, size_t length, const std::
     return impl_->loadFromMemory(data, length, password);
 }
 
+bool PdfDocument::loadFromBuffer(std::vector<uint8_t>&& data, const std::string& password) {
+    return impl_->loadFromBuffer(std::move(data), password);
+}
+
+std::unique_ptr<PdfDocument> PdfDocument::fork() const {
+    auto copy = std::make_unique<PdfDocument>();
+    if (!copy->impl_->loadFork(*impl_)) {
+        impl_->lastError_ = "Failed to fork document: " + copy->impl_->lastError_;
+        return nullptr;
+    }
+
+    // An unedited field table describes the fork too - copy it instead of describing every
+    // field again; the fork's Poppler fields are resolved in one walk on first use
+    if (impl_->fieldsCached_ && !impl_->modified_) {
+        copy->impl_->adoptFieldTable(copy->impl_->internFields(impl_->cachedFields_), impl_->fieldRefs_,
+                                     impl_->loadedAttrs_);
+    }
+    return copy;
+}
+
+std::vector<uint8_t> PdfDocument::compileTemplate() const {
+    return const_cast<Impl*>(impl_.get())->compileTemplate();
+}
+
+bool PdfDocument::loadTemplate(const uint8_t* data, size_t length) {
+    return impl_->loadTemplate(data, length);
+}
+
+bool PdfDocument::loadFromRangeReader(uint64_t length, ByteRangeReader reader, const std::string& password) {
+    return impl_->loadFromRangeReader(length, std::move(reader), password);
+}
+
 bool PdfDocument::loadFromFile(const std::string& path, const std::string& password) {
     return impl_->loadFromFile(path, password);
 }
@@ -587,53 +2082,300 @@ bool PdfDocument::hasAcroForm() const {
 }
 
 std::vector<PdfFormField> PdfDocument::getFormFields() const {
-    const_cast<Impl*>(impl_.get())->cacheFormFields();
-    return impl_->cachedFields_;
+    return getFormFields(FieldAttrAll);
 }
 
-PdfFormField* PdfDocument::getFieldByName(const std::string& name) {
-    impl_->cacheFormFields();
+std::vector<PdfFormField> PdfDocument::getFormFields(uint32_t attrs) const {
+    auto* impl = const_cast<Impl*>(impl_.get());
+    impl->ensureAttributes(attrs);
+
+    // Copy only the requested groups (skips e.g. every option string for names-only)
+    std::vector<PdfFormField> result(impl->cachedFields_.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        copyAttributes(impl->cachedFields_[i], result[i], attrs);
+    }
+    return result;
+}
+
+FieldColumns PdfDocument::getFormFieldColumns(uint32_t attrs) const {
+    auto* impl = const_cast<Impl*>(impl_.get());
+    impl->ensureAttributes(attrs);
+
+    const auto& fields = impl->cachedFields_;
+    FieldColumns columns;
+    columns.count = static_cast<uint32_t>(fields.size());
+    columns.attrs = attrs & FieldAttrAll;
+
+    const bool wantStrings = attrs & (FieldAttrNames | FieldAttrValue | FieldAttrOptions);
+    if (wantStrings) {
+        columns.stringOffsets.reserve(fields.size() * FieldColumns::kStringsPerField + 1);
+        columns.stringOffsets.push_back(0);
+    }
+    auto addString = [&columns](const std::string_view* str) {
+        if (str) {
+            columns.strings += *str;
+        }
+        columns.stringOffsets.push_back(static_cast<uint32_t>(columns.strings.size()));
+    };
+
+    if (attrs & FieldAttrType) {
+        columns.types.reserve(fields.size());
+    }
+    if (attrs & (FieldAttrType | FieldAttrValue)) {
+        columns.flags.reserve(fields.size());
+    }
+    if (attrs & FieldAttrGeometry) {
+        columns.pageIndices.reserve(fields.size());
+        columns.geometry.reserve(fields.size() * 4);
+    }
+
+    const bool names = attrs & FieldAttrNames;
+    const bool values = attrs & FieldAttrValue;
+    for (const auto& f : fields) {
+        if (wantStrings) {
+            addString(names ? &f.name : nullptr);
+            addString(names ? &f.fullName : nullptr);
+            addString(values ? &f.value : nullptr);
+            addString(values ? &f.defaultValue : nullptr);
+            addString(values ? &f.exportValue : nullptr);
+        }
+        if (attrs & FieldAttrType) {
+            columns.types.push_back(static_cast<uint8_t>(f.type));
+        }
+        if (attrs & (FieldAttrType | FieldAttrValue)) {
+            uint8_t flags = 0;
+            if (f.readOnly) flags |= FieldFlagReadOnly;
+            if (f.required) flags |= FieldFlagRequired;
+            if (f.isChecked) flags |= FieldFlagChecked;
+            columns.flags.push_back(flags);
+        }
+        if (attrs & FieldAttrGeometry) {
+            columns.pageIndices.push_back(f.pageIndex);
+            columns.geometry.insert(columns.geometry.end(), {f.x, f.y, f.width, f.height});
+        }
+    }
 
-    for (auto& field : impl_->cachedFields_) {
-        if (field.name == name || field.fullName == name) {
-            return &field;
+    if (attrs & FieldAttrOptions) {
+        uint32_t next = static_cast<uint32_t>(columns.stringOffsets.size() - 1);
+        columns.optionOffsets.reserve(fields.size() + 1);
+        columns.optionOffsets.push_back(next);
+        for (const auto& f : fields) {
+            for (const auto& option : f.options) {
+                addString(&option);
+            }
+            next += static_cast<uint32_t>(f.options.size());
+            columns.optionOffsets.push_back(next);
         }
     }
-    return nullptr;
+
+    return columns;
 }
 
-bool PdfDocument::setFieldValue(const std::string& name, const std::string& value) {
-    // First try as text field
-    ::FormField* field = impl_->findFormField(name);
-    if (!field) {
-        impl_->lastError_ = "Field not found: " + name;
-        return false;
+std::vector<PdfFormField> PdfDocument::getFormFieldsForPage(int pageIndex) const {
+    std::vector<PdfFormField> result;
+    const auto* fields = const_cast<Impl*>(impl_.get())->pageFormFields(pageIndex);
+    if (fields) {
+        result.reserve(fields->size());
+        for (const auto& field : *fields) {
+            result.push_back(toFormField(field));
+        }
     }
+    return result;
+}
 
-    switch (field->getType()) {
-        case formText:
-            return impl_->setTextFieldValue(name, value);
-        case formChoice:
-            return impl_->setChoiceFieldValue(name, value);
-        case formButton:
-            // For buttons, interpret non-empty string as "checked"
-            return impl_->setButtonFieldValue(name, !value.empty() && value != "0" && value != "false");
-        default:
-            impl_->lastError_ = "Unsupported field type for setValue";
-            return false;
+PdfFormField* PdfDocument::getFieldByName(const std::string& name) {
+    size_t index = impl_->lookupField(name);
+    if (!Impl::isValidIndex(index)) {
+        return nullptr;
+    }
+    impl_->lookupResult_ = toFormField(impl_->syncedFields()[index]);
+    return &impl_->lookupResult_;
+}
+
+MemoryStats PdfDocument::getMemoryStats() const {
+    const Impl& impl = *impl_;
+    MemoryStats stats;
+    stats.fieldCount = impl.cachedFields_.size();
+    stats.internedStrings = impl.strings_.count();
+    stats.stringBytes = impl.strings_.bytesUsed();
+    stats.stringBytesRequested = impl.strings_.bytesRequested();
+    stats.arenaCapacity = impl.strings_.capacity();
+
+    stats.fieldTableBytes = impl.cachedFields_.capacity() * sizeof(FieldEntry) +
+                            impl.fieldRefs_.capacity() * sizeof(Ref) +
+                            impl.formFields_.capacity() * sizeof(::FormField*);
+    for (const auto& field : impl.cachedFields_) {
+        stats.fieldTableBytes += field.options.capacity() * sizeof(std::string_view);
+    }
+
+    // Node-based containers: one node (key, value, next, cached hash) per entry plus buckets
+    stats.indexBytes = impl.strings_.indexBytes() +
+                       impl.fieldMap_.bucket_count() * sizeof(void*) +
+                       impl.fieldMap_.size() * (sizeof(std::string_view) + sizeof(size_t) + 2 * sizeof(void*));
+    return stats;
+}
+
+std::vector<WidgetRect> PdfDocument::getFieldWidgets(const std::string& name) {
+    std::vector<WidgetRect> result;
+    size_t index = impl_->lookupField(name);
+    if (!Impl::isValidIndex(index)) {
+        return result;
+    }
+
+    impl_->cacheWidgets();
+    for (size_t page = 0; page < impl_->pageWidgets_.size(); ++page) {
+        for (const auto& box : impl_->pageWidgets_[page].boxes) {
+            if (box.field == index) {
+                result.push_back({static_cast<int>(page), box.x1, box.y1, box.x2 - box.x1, box.y2 - box.y1});
+            }
+        }
     }
+    return result;
+}
+
+std::vector<PdfFormField> PdfDocument::getFieldsAt(int pageIndex, double x, double y) {
+    return impl_->fieldsAtIndices(impl_->hitTest(pageIndex, x, y, x, y));
+}
+
+std::vector<PdfFormField> PdfDocument::getFieldsInRect(int pageIndex, double x, double y,
+                                                       double width, double height) {
+    return impl_->fieldsAtIndices(impl_->hitTest(pageIndex, x, y, x + width, y + height));
+}
+
+bool PdfDocument::setFieldValue(const std::string& name, const std::string& value) {
+    size_t index = impl_->lookupField(name);
+    return Impl::isValidIndex(index) && impl_->setFieldValue(index, value);
 }
 
 bool PdfDocument::setCheckboxValue(const std::string& name, bool checked) {
-    return impl_->setButtonFieldValue(name, checked);
+    size_t index = impl_->lookupField(name);
+    return Impl::isValidIndex(index) && impl_->setButtonFieldValue(index, checked);
+}
+
+bool PdfDocument::setChoiceValues(const std::string& name, const std::vector<std::string>& values) {
+    size_t index = impl_->lookupField(name);
+    return Impl::isValidIndex(index) && impl_->setChoiceFieldValues(index, values);
 }
 
 bool PdfDocument::setFieldValues(const std::vector<std::pair<std::string, std::string>>& values) {
+    std::vector<std::pair<std::string, FieldValue>> typed;
+    typed.reserve(values.size());
+    for (const auto& [name, value] : values) {
+        typed.emplace_back(name, FieldValue(std::in_place_type<std::string>, value));
+    }
+
+    // Continue trying other fields after a failure
+    auto statuses = impl_->applyFieldValues(typed, false);
+    return std::all_of(statuses.begin(), statuses.end(),
+                       [](FieldStatus status) { return status == FieldStatus::Ok; });
+}
+
+std::vector<FieldStatus> PdfDocument::applyFieldValues(
+    const std::vector<std::pair<std::string, FieldValue>>& values, bool atomic) {
+    return impl_->applyFieldValues(values, atomic);
+}
+
+// Decode the buffer of applyPackedFieldValues; false if it is truncated,
+// has an unknown tag or trailing bytes
+static bool decodeFieldValues(const uint8_t* data, size_t length,
+                              std::vector<std::pair<std::string, FieldValue>>& out) {
+    BlobReader in(data, length);
+    uint32_t count = 0;
+    if (!in.get(count) || count > length) return false;  // Bound the reserve by the buffer size
+    out.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string name;
+        uint8_t tag = 0;
+        if (!in.getString(name) || !in.get(tag)) return false;
+
+        switch (static_cast<PackedValueTag>(tag)) {
+            case PackedValueTag::String: {
+                std::string text;
+                if (!in.getString(text)) return false;
+                out.emplace_back(std::move(name), FieldValue(std::in_place_type<std::string>, std::move(text)));
+                break;
+            }
+            case PackedValueTag::Bool: {
+                uint8_t flag = 0;
+                if (!in.get(flag)) return false;
+                out.emplace_back(std::move(name), FieldValue(flag != 0));
+                break;
+            }
+            case PackedValueTag::Number: {
+                double number = 0.0;
+                if (!in.get(number)) return false;
+                out.emplace_back(std::move(name), FieldValue(number));
+                break;
+            }
+            case PackedValueTag::StringList: {
+                uint32_t items = 0;
+                if (!in.get(items) || items > length) return false;
+                std::vector<std::string> list(items);
+                for (auto& item : list) {
+                    if (!in.getString(item)) return false;
+                }
+                out.emplace_back(std::move(name), FieldValue(std::move(list)));
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return in.atEnd();
+}
+
+std::vector<FieldStatus> PdfDocument::applyPackedFieldValues(const uint8_t* data, size_t length, bool atomic) {
+    std::vector<std::pair<std::string, FieldValue>> values;
+    if (!decodeFieldValues(data, length, values)) {
+        impl_->lastError_ = "Malformed packed field values";
+        return {};
+    }
+    return impl_->applyFieldValues(values, atomic);
+}
+
+std::vector<PdfFormField> PdfDocument::getFieldsUnder(const std::string& prefix) {
+    std::vector<size_t> indices = impl_->subtreeFields(prefix);
+    return impl_->fieldsAtIndices(indices);
+}
+
+bool PdfDocument::setFieldValuesUnder(const std::string& prefix,
+                                      const std::vector<std::pair<std::string, std::string>>& values) {
+    // Resolve relative names against the subtree only, not the whole form
+    std::vector<size_t> subtree = impl_->subtreeFields(prefix);
+    std::unordered_map<std::string_view, size_t> byName;
+    byName.reserve(subtree.size());
+    for (size_t index : subtree) {
+        std::string_view fullName = impl_->cachedFields_[index].fullName;
+        byName.emplace(prefix.empty() ? fullName : fullName.substr(std::min(fullName.size(), prefix.size() + 1)), index);
+    }
+
     bool allSuccess = true;
     for (const auto& [name, value] : values) {
-        if (!setFieldValue(name, value)) {
+        auto it = byName.find(name);
+        if (it == byName.end()) {
+            impl_->lastError_ = "Field not found: " + (prefix.empty() ? name : prefix + "." + name);
+            allSuccess = false;
+            continue;
+        }
+        if (!impl_->setFieldValue(it->second, value)) {
+            allSuccess = false;
+        }
+    }
+    return allSuccess;
+}
+
+bool PdfDocument::resetFieldsUnder(const std::string& prefix) {
+    std::vector<size_t> subtree = impl_->subtreeFields(prefix);
+    if (subtree.empty()) {
+        impl_->lastError_ = "No fields under: " + prefix;
+        return false;
+    }
+
+    bool allSuccess = true;
+    for (size_t index : subtree) {
+        if (!impl_->resetField(index)) {
             allSuccess = false;
-            // Continue trying other fields
         }
     }
     return allSuccess;
@@ -643,22 +2385,16 @@ bool PdfDocument::flattenForm() {
     return impl_->flattenForm();
 }
 
-std::vector<uint8_t> PdfDocument::saveToMemory() const {
-    return const_cast<Impl*>(impl_.get())->saveToMemory();
+std::vector<uint8_t> PdfDocument::saveToMemory(SaveMode mode) const {
+    return const_cast<Impl*>(impl_.get())->saveToMemory(mode);
 }
 
-bool PdfDocument::saveToFile(const std::string& path) const {
-    auto data = saveToMemory();
-    if (data.empty()) return false;
-
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
-        impl_->lastError_ = "Failed to open file for writing: " + path;
-        return false;
-    }
+bool PdfDocument::saveToSink(const ByteSink& sink, SaveMode mode) const {
+    return const_cast<Impl*>(impl_.get())->saveToSink(sink, mode);
+}
 
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
-    return file.good();
+bool PdfDocument::saveToFile(const std::string& path, SaveMode mode) const {
+    return const_cast<Impl*>(impl_.get())->saveToFile(path, mode);
 }
 
 std::vector<uint8_t> PdfDocument::renderPageToPng(int pageIndex, double dpi) const {
@@ -692,4 +2428,18 @@ FieldType stringToFieldType(const std::string& str) {
     return FieldType::Unknown;
 }
 
+std::string saveModeToString(SaveMode mode) {
+    switch (mode) {
+        case SaveMode::Incremental: return "incremental";
+        case SaveMode::FullRewrite: return "rewrite";
+        default: return "auto";
+    }
+}
+
+SaveMode stringToSaveMode(const std::string& str) {
+    if (str == "incremental") return SaveMode::Incremental;
+    if (str == "rewrite") return SaveMode::FullRewrite;
+    return SaveMode::Auto;
+}
+
 } // namespace pdffiller
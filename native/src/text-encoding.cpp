@@ -0,0 +1,327 @@
+// Text string encoding for values written into the PDF
+#include "text-encoding.h"
+
+#include <poppler/PDFDocEncoding.h>
+#include <poppler/UTF.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+// ASCII runs are scanned and widened 16 bytes at a time where SIMD is available
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define PDFFILLER_SIMD_WASM 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PDFFILLER_SIMD_SSE2 1
+#endif
+
+namespace pdffiller {
+
+static constexpr uint32_t kInvalidCodePoint = 0xFFFFFFFF;
+
+// Length of the leading run of ASCII bytes. With `printableOnly` the run stops
+// at anything outside 0x20..0x7E as well: those are the only bytes that UTF-8
+// and PDFDocEncoding are guaranteed to encode identically.
+static size_t asciiRun(const uint8_t* data, size_t length, bool printableOnly) {
+    size_t i = 0;
+#if defined(PDFFILLER_SIMD_WASM)
+    const v128_t space = wasm_i8x16_splat(0x20);
+    const v128_t del = wasm_i8x16_splat(0x7f);
+    for (; i + 16 <= length; i += 16) {
+        v128_t v = wasm_v128_load(data + i);
+        // Signed compare: bytes >= 0x80 are negative, so "< 0x20" also catches them
+        v128_t stop = printableOnly ? wasm_v128_or(wasm_i8x16_lt(v, space), wasm_i8x16_eq(v, del)) : v;
+        uint32_t mask = wasm_i8x16_bitmask(stop);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#elif defined(PDFFILLER_SIMD_SSE2)
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i stop = printableOnly ? _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)) : v;
+        int mask = _mm_movemask_epi8(stop);
+        if (mask) return i + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+#endif
+    for (; i < length; ++i) {
+        uint8_t c = data[i];
+        if (c >= 0x80 || (printableOnly && (c < 0x20 || c == 0x7f))) break;
+    }
+    return i;
+}
+
+// Append `length` ASCII bytes as UTF-16BE (each byte preceded by a zero byte)
+static void widenAscii(const uint8_t* data, size_t length, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + length * 2);
+    auto* dest = reinterpret_cast<uint8_t*>(&out[start]);
+
+    size_t i = 0;
+#if defined(PDFFILLER_SIMD_WASM)
+    const v128_t zero = wasm_i8x16_splat(0);
+    for (; i + 16 <= length; i += 16) {
+        v128_t v = wasm_v128_load(data + i);
+        wasm_v128_store(dest + i * 2, wasm_i8x16_shuffle(zero, v, 0, 16, 0, 17, 0, 18, 0, 19, 0, 20, 0, 21, 0, 22, 0, 23));
+        wasm_v128_store(dest + i * 2 + 16, wasm_i8x16_shuffle(zero, v, 0, 24, 0, 25, 0, 26, 0, 27, 0, 28, 0, 29, 0, 30, 0, 31));
+    }
+#elif defined(PDFFILLER_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2 + 16), _mm_unpackhi_epi8(zero, v));
+    }
+#endif
+    for (; i < length; ++i) {
+        dest[i * 2] = 0;
+        dest[i * 2 + 1] = data[i];
+    }
+}
+
+// Decode the UTF-8 sequence at data[i] and advance past it. Overlong forms,
+// surrogates and truncated sequences yield kInvalidCodePoint (one byte consumed).
+static uint32_t decodeUtf8(const uint8_t* data, size_t length, size_t& i) {
+    uint8_t lead = data[i];
+    size_t extra;
+    uint32_t cp, min;
+    if (lead < 0x80) {
+        ++i;
+        return lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+        extra = 1; cp = lead & 0x1F; min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2; cp = lead & 0x0F; min = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3; cp = lead & 0x07; min = 0x10000;
+    } else {
+        ++i;
+        return kInvalidCodePoint;
+    }
+
+    if (length - i <= extra) {
+        ++i;
+        return kInvalidCodePoint;
+    }
+    for (size_t k = 1; k <= extra; ++k) {
+        uint8_t c = data[i + k];
+        if ((c & 0xC0) != 0x80) {
+            ++i;
+            return kInvalidCodePoint;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        ++i;
+        return kInvalidCodePoint;
+    }
+    i += extra + 1;
+    return cp;
+}
+
+// Unicode -> PDFDocEncoding byte, built from Poppler's decoding table
+static const std::unordered_map<uint32_t, uint8_t>& pdfDocEncodingReverse() {
+    static const std::unordered_map<uint32_t, uint8_t> table = [] {
+        std::unordered_map<uint32_t, uint8_t> map;
+        // Descending, so the lowest byte wins if a code point appears twice
+        for (int b = 255; b > 0; --b) {
+            if (pdfDocEncoding[b] != 0) {
+                map[pdfDocEncoding[b]] = static_cast<uint8_t>(b);
+            }
+        }
+        return map;
+    }();
+    return table;
+}
+
+// Leading bytes a reader takes for a byte order mark: FE FF (UTF-16BE),
+// FF FE (UTF-16LE) and EF BB (UTF-8, matched on two bytes). The encoder
+// never produces them as PDFDocEncoding and the decoder never reads them as such.
+static bool hasBomPrefix(const uint8_t* data, size_t length) {
+    return length >= 2 && ((data[0] == 0xFE && data[1] == 0xFF) ||
+                           (data[0] == 0xFF && data[1] == 0xFE) ||
+                           (data[0] == 0xEF && data[1] == 0xBB));
+}
+
+bool utf8ToPdfDocEncoding(std::string_view utf8, std::string& out) {
+    const auto* data = reinterpret_cast<const uint8_t*>(utf8.data());
+    const size_t length = utf8.size();
+    const auto& reverse = pdfDocEncodingReverse();
+
+    out.clear();
+    out.reserve(length);
+    size_t i = 0;
+    while (i < length) {
+        size_t run = asciiRun(data + i, length - i, true);
+        out.append(utf8.data() + i, run);
+        i += run;
+        if (i == length) break;
+
+        uint32_t cp = decodeUtf8(data, length, i);
+        auto it = cp == kInvalidCodePoint ? reverse.end() : reverse.find(cp);
+        if (it == reverse.end()) {
+            return false;
+        }
+        out.push_back(static_cast<char>(it->second));
+    }
+
+    // "þÿ", "ÿþ" or "ï»" at the start would be read back as a BOM
+    return !hasBomPrefix(reinterpret_cast<const uint8_t*>(out.data()), out.size());
+}
+
+std::string utf8ToUtf16Be(std::string_view utf8) {
+    const auto* data = reinterpret_cast<const uint8_t*>(utf8.data());
+    const size_t length = utf8.size();
+
+    std::string out;
+    out.reserve(2 + length * 2);
+    out += "\xFE\xFF";
+
+    size_t i = 0;
+    while (i < length) {
+        size_t run = asciiRun(data + i, length - i, false);
+        widenAscii(data + i, run, out);
+        i += run;
+        if (i == length) break;
+
+        uint32_t cp = decodeUtf8(data, length, i);
+        if (cp == kInvalidCodePoint) {
+            cp = 0xFFFD;
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            uint32_t high = 0xD800 | (cp >> 10);
+            uint32_t low = 0xDC00 | (cp & 0x3FF);
+            out.push_back(static_cast<char>(high >> 8));
+            out.push_back(static_cast<char>(high & 0xFF));
+            out.push_back(static_cast<char>(low >> 8));
+            out.push_back(static_cast<char>(low & 0xFF));
+        } else {
+            out.push_back(static_cast<char>(cp >> 8));
+            out.push_back(static_cast<char>(cp & 0xFF));
+        }
+    }
+    return out;
+}
+
+static void appendUtf8(uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Length (in code units) of the leading run of ASCII UTF-16BE code units in
+// `units` big-endian byte pairs, appending them to `out` as single bytes
+static size_t narrowAsciiUtf16(const uint8_t* data, size_t units, std::string& out) {
+    size_t i = 0;
+#if defined(PDFFILLER_SIMD_WASM)
+    // Loaded as little-endian lanes, a BE unit 00 xx is 0xxx00: ASCII iff lane & 0x80FF == 0
+    const v128_t nonAscii = wasm_i16x8_splat(static_cast<int16_t>(0x80FF));
+    for (; i + 8 <= units; i += 8) {
+        v128_t v = wasm_v128_load(data + i * 2);
+        if (wasm_v128_any_true(wasm_v128_and(v, nonAscii))) break;
+        v128_t low = wasm_u16x8_shr(v, 8);
+        uint64_t bytes = wasm_i64x2_extract_lane(wasm_u8x16_narrow_i16x8(low, low), 0);
+        out.append(reinterpret_cast<const char*>(&bytes), 8);
+    }
+#elif defined(PDFFILLER_SIMD_SSE2)
+    const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0x80FF));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= units; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, nonAscii), zero)) != 0xFFFF) break;
+        __m128i low = _mm_srli_epi16(v, 8);
+        alignas(16) char bytes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(bytes), _mm_packus_epi16(low, low));
+        out.append(bytes, 8);
+    }
+#endif
+    for (; i < units; ++i) {
+        if (data[i * 2] != 0 || data[i * 2 + 1] >= 0x80) break;
+        out.push_back(static_cast<char>(data[i * 2 + 1]));
+    }
+    return i;
+}
+
+static std::string utf16BeToUtf8(const uint8_t* data, size_t units) {
+    std::string out;
+    out.reserve(units);
+
+    size_t i = 0;
+    while (i < units) {
+        i += narrowAsciiUtf16(data + i * 2, units - i, out);
+        if (i == units) break;
+
+        uint32_t unit = (data[i * 2] << 8) | data[i * 2 + 1];
+        ++i;
+        if (unit >= 0xD800 && unit <= 0xDBFF && i < units) {
+            uint32_t next = (data[i * 2] << 8) | data[i * 2 + 1];
+            if (next >= 0xDC00 && next <= 0xDFFF) {
+                appendUtf8(0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00), out);
+                ++i;
+                continue;
+            }
+        }
+        appendUtf8(unit >= 0xD800 && unit <= 0xDFFF ? 0xFFFD : unit, out);
+    }
+    return out;
+}
+
+std::string pdfTextToUtf8(std::string_view text) {
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t length = text.size();
+
+    if (length >= 2 && data[0] == 0xFE && data[1] == 0xFF) {
+        return utf16BeToUtf8(data + 2, (length - 2) / 2);
+    }
+    if (hasBomPrefix(data, length)) {
+        return TextStringToUtf8(std::string(text));
+    }
+
+    // PDFDocEncoding; names and most values are printable ASCII and come back unchanged
+    size_t run = asciiRun(data, length, true);
+    if (run == length) {
+        return std::string(text);
+    }
+
+    std::string out;
+    out.reserve(length + length / 2);
+    size_t i = 0;
+    while (i < length) {
+        run = asciiRun(data + i, length - i, true);
+        out.append(text.data() + i, run);
+        i += run;
+        if (i == length) break;
+
+        uint32_t cp = pdfDocEncoding[data[i]];
+        if (cp == 0) {
+            return TextStringToUtf8(std::string(text));
+        }
+        appendUtf8(cp, out);
+        ++i;
+    }
+    return out;
+}
+
+std::string utf8ToPdfText(std::string_view utf8) {
+    std::string out;
+    if (utf8ToPdfDocEncoding(utf8, out)) {
+        return out;
+    }
+    return utf8ToUtf16Be(utf8);
+}
+
+} // namespace pdffiller
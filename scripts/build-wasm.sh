@@ -72,6 +72,7 @@ fi
 # Source files
 SOURCES=(
     "${NATIVE_DIR}/src/pdf-filler.cpp"
+    "${NATIVE_DIR}/src/text-encoding.cpp"
     "${NATIVE_DIR}/src/bindings.cpp"
 )
 
@@ -79,6 +80,8 @@ SOURCES=(
 EMFLAGS=(
     "-O2"
     "-std=c++17"
+    # WASM SIMD for text transcoding (text-encoding.cpp)
+    "-msimd128"
     "-s" "WASM=1"
     "-s" "MODULARIZE=1"
     "-s" "EXPORT_NAME='createPdfFillerModule'"
@@ -138,3 +141,20 @@ else
     echo "Error: Build failed - output files not created"
     exit 1
 fi
+
+# Native microbenchmarks (not part of the package): BUILD_BENCH=1
+if [ "${BUILD_BENCH:-0}" = "1" ]; then
+    echo ""
+    echo "=== Building benchmarks ==="
+    em++ \
+        -O2 -std=c++17 -msimd128 \
+        -s ALLOW_MEMORY_GROWTH=1 \
+        -s ENVIRONMENT=node \
+        "${DEFINES[@]}" \
+        "${INCLUDES[@]}" \
+        "${NATIVE_DIR}/bench/text-encoding-bench.cpp" \
+        "${NATIVE_DIR}/src/text-encoding.cpp" \
+        "${LIBS[@]}" \
+        -o "${BUILD_DIR}/text-encoding-bench.js"
+    echo "  - ${BUILD_DIR}/text-encoding-bench.js (run with: node build/text-encoding-bench.js)"
+fi
@@ -0,0 +1,93 @@
+/**
+ * Packed batch of field values (see PdfFillerInstance.applyPackedFieldValues).
+ * The whole batch is written straight into the WASM heap and decoded natively,
+ * instead of one embind property read and string copy per field.
+ */
+
+import type { FieldValue, PdfFillerModule } from './types';
+
+// pdffiller::PackedValueTag
+const TAG_STRING = 0;
+const TAG_BOOL = 1;
+const TAG_NUMBER = 2;
+const TAG_STRING_LIST = 3;
+
+const encoder = new TextEncoder();
+
+// Worst case for a length-prefixed string: 3 UTF-8 bytes per UTF-16 unit
+function stringBound(str: string): number {
+  return 4 + str.length * 3;
+}
+
+// Values outside FieldValue are passed as strings, like the object API does
+function normalize(value: FieldValue | null | undefined): FieldValue {
+  if (value === null || value === undefined) return '';
+  if (Array.isArray(value)) return value.map(String);
+  if (typeof value === 'string' || typeof value === 'boolean' || typeof value === 'number') return value;
+  return String(value);
+}
+
+/**
+ * Write `values` into a heap allocation, call `fn` with its address and byte
+ * length, and free it again. Layout (little-endian): u32 entry count, then per
+ * entry a length-prefixed UTF-8 name, a tag byte and the value.
+ */
+export function withPackedFieldValues<T>(
+  module: PdfFillerModule,
+  values: Record<string, FieldValue>,
+  fn: (address: number, length: number) => T
+): T {
+  const entries = Object.keys(values).map(name => [name, normalize(values[name])] as const);
+
+  let bound = 4;
+  for (const [name, value] of entries) {
+    bound += stringBound(name) + 1;
+    if (typeof value === 'string') bound += stringBound(value);
+    else if (typeof value === 'boolean') bound += 1;
+    else if (typeof value === 'number') bound += 8;
+    else bound += value.reduce((n, item) => n + stringBound(item), 4);
+  }
+
+  const address = module._malloc(bound);
+  if (!address) {
+    throw new Error(`Failed to allocate ${bound} bytes for field values`);
+  }
+  try {
+    // Take the views after _malloc: growing memory replaces the heap buffer
+    const heap = module.HEAPU8;
+    const view = new DataView(heap.buffer, heap.byteOffset, heap.byteLength);
+    let pos = address;
+
+    const putString = (str: string) => {
+      const { written } = encoder.encodeInto(str, heap.subarray(pos + 4, pos + stringBound(str)));
+      view.setUint32(pos, written, true);
+      pos += 4 + written;
+    };
+
+    view.setUint32(pos, entries.length, true);
+    pos += 4;
+    for (const [name, value] of entries) {
+      putString(name);
+      if (typeof value === 'string') {
+        view.setUint8(pos++, TAG_STRING);
+        putString(value);
+      } else if (typeof value === 'boolean') {
+        view.setUint8(pos++, TAG_BOOL);
+        view.setUint8(pos++, value ? 1 : 0);
+      } else if (typeof value === 'number') {
+        view.setUint8(pos++, TAG_NUMBER);
+        view.setFloat64(pos, value, true);
+        pos += 8;
+      } else {
+        view.setUint8(pos++, TAG_STRING_LIST);
+        view.setUint32(pos, value.length, true);
+        pos += 4;
+        value.forEach(putString);
+      }
+    }
+
+    return fn(address, pos - address);
+  } finally {
+    module._free(address);
+  }
+}
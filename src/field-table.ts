@@ -0,0 +1,140 @@
+/**
+ * Lazy view over the columnar field export (see PdfFillerInstance.getFormFieldColumns)
+ */
+
+import type { FieldColumns, FieldType, FormField } from './types';
+import { FIELD_ATTRIBUTE_BITS } from './types';
+
+// Index is the native pdffiller::FieldType value
+const FIELD_TYPES: FieldType[] = [
+  'unknown',
+  'text',
+  'button',
+  'checkbox',
+  'radio',
+  'choice',
+  'signature',
+];
+
+// pdffiller::FieldFlag
+const FLAG_READ_ONLY = 1 << 0;
+const FLAG_REQUIRED = 1 << 1;
+const FLAG_CHECKED = 1 << 2;
+
+// pdffiller::FieldColumns string slots per field
+const NAME = 0;
+const FULL_NAME = 1;
+const VALUE = 2;
+const DEFAULT_VALUE = 3;
+const EXPORT_VALUE = 4;
+const STRINGS_PER_FIELD = 5;
+
+const decoder = new TextDecoder();
+
+/**
+ * Field table backed by packed typed arrays. Column accessors read a single
+ * attribute without building an object; `get()` materializes a FormField on
+ * first access and caches it.
+ */
+export class FieldTable<T extends Partial<FormField> = FormField> implements Iterable<T> {
+  private readonly cache: (T | undefined)[];
+
+  constructor(private readonly columns: FieldColumns) {
+    this.cache = new Array(columns.count);
+  }
+
+  /** Number of fields */
+  get length(): number {
+    return this.columns.count;
+  }
+
+  name(index: number): string {
+    return this.string(index * STRINGS_PER_FIELD + NAME);
+  }
+
+  fullName(index: number): string {
+    return this.string(index * STRINGS_PER_FIELD + FULL_NAME);
+  }
+
+  value(index: number): string {
+    return this.string(index * STRINGS_PER_FIELD + VALUE);
+  }
+
+  type(index: number): FieldType {
+    return FIELD_TYPES[this.columns.types[index] ?? 0] ?? 'unknown';
+  }
+
+  pageIndex(index: number): number {
+    return this.columns.pageIndices[index] ?? 0;
+  }
+
+  /** Materialize field `index` with the attribute groups this table was built with */
+  get(index: number): T {
+    const cached = this.cache[index];
+    if (cached) {
+      return cached;
+    }
+
+    const { attrs, flags, geometry, optionOffsets } = this.columns;
+    const base = index * STRINGS_PER_FIELD;
+    const flagBits = flags[index] ?? 0;
+    const field: Partial<FormField> = {};
+
+    if (attrs & FIELD_ATTRIBUTE_BITS.names) {
+      field.name = this.string(base + NAME);
+      field.fullName = this.string(base + FULL_NAME);
+    }
+    if (attrs & FIELD_ATTRIBUTE_BITS.type) {
+      field.type = this.type(index);
+      field.readOnly = (flagBits & FLAG_READ_ONLY) !== 0;
+      field.required = (flagBits & FLAG_REQUIRED) !== 0;
+    }
+    if (attrs & FIELD_ATTRIBUTE_BITS.value) {
+      field.value = this.string(base + VALUE);
+      field.defaultValue = this.string(base + DEFAULT_VALUE);
+      field.exportValue = this.string(base + EXPORT_VALUE);
+      field.isChecked = (flagBits & FLAG_CHECKED) !== 0;
+    }
+    if (attrs & FIELD_ATTRIBUTE_BITS.options) {
+      const options: string[] = [];
+      const end = optionOffsets[index + 1] ?? 0;
+      for (let i = optionOffsets[index] ?? 0; i < end; i++) {
+        options.push(this.string(i));
+      }
+      field.options = options;
+    }
+    if (attrs & FIELD_ATTRIBUTE_BITS.geometry) {
+      field.pageIndex = this.pageIndex(index);
+      field.x = geometry[index * 4] ?? 0;
+      field.y = geometry[index * 4 + 1] ?? 0;
+      field.width = geometry[index * 4 + 2] ?? 0;
+      field.height = geometry[index * 4 + 3] ?? 0;
+    }
+
+    this.cache[index] = field as T;
+    return field as T;
+  }
+
+  /** Materialize every field */
+  toArray(): T[] {
+    const result = new Array<T>(this.length);
+    for (let i = 0; i < this.length; i++) {
+      result[i] = this.get(i);
+    }
+    return result;
+  }
+
+  *[Symbol.iterator](): Iterator<T> {
+    for (let i = 0; i < this.length; i++) {
+      yield this.get(i);
+    }
+  }
+
+  private string(i: number): string {
+    const { strings, stringOffsets } = this.columns;
+    if (i + 1 >= stringOffsets.length) {
+      return '';
+    }
+    return decoder.decode(strings.subarray(stringOffsets[i], stringOffsets[i + 1]));
+  }
+}
@@ -2,7 +2,22 @@
  * PDF Form Filler - TypeScript wrapper for Poppler WASM module
  */
 
-import type { PdfFillerModule, PdfFillerInstance, FormField } from './types';
+import type {
+  PdfFillerModule,
+  PdfFillerInstance,
+  FormField,
+  FieldAttribute,
+  WidgetRect,
+  MemoryStats,
+  FieldValue,
+  FieldResult,
+  ApplyOptions,
+  ByteRangeProvider,
+  SaveOptions,
+} from './types';
+import { FIELD_ATTRIBUTE_BITS, ALL_FIELD_ATTRIBUTES, FIELD_STATUSES } from './types';
+import { FieldTable } from './field-table';
+import { withPackedFieldValues } from './field-buffer';
 
 // Dynamic import for the WASM module
 let modulePromise: Promise<PdfFillerModule> | null = null;
@@ -53,17 +68,18 @@ export class PdfForm {
   private module: PdfFillerModule;
   private instance: PdfFillerInstance;
   private _loaded = false;
+  private _disposed = false;
 
-  private constructor(module: PdfFillerModule) {
+  private constructor(module: PdfFillerModule, instance?: PdfFillerInstance) {
     this.module = module;
-    this.instance = new module.PdfFiller();
+    this.instance = instance ?? new module.PdfFiller();
   }
 
   /**
    * Create a new PdfForm instance and load a PDF from an ArrayBuffer
    */
   static async fromArrayBuffer(
-    data: ArrayBuffer,
+    data: ArrayBuffer | ArrayBufferView,
     password?: string
   ): Promise<PdfForm> {
     const module = await initPdfFiller();
@@ -72,6 +88,7 @@ export class PdfForm {
     const success = form.instance.loadFromArrayBuffer(data, password ?? '');
     if (!success) {
       const error = form.instance.getLastError();
+      form.dispose();
       throw new Error(`Failed to load PDF: ${error}`);
     }
 
@@ -86,12 +103,40 @@ export class PdfForm {
     data: Uint8Array,
     password?: string
   ): Promise<PdfForm> {
-    return PdfForm.fromArrayBuffer(data.buffer as ArrayBuffer, password);
+    // Pass the view itself: Node Buffers are often slices of a larger pool
+    return PdfForm.fromArrayBuffer(data, password);
+  }
+
+  /**
+   * Create a new PdfForm instance backed by a byte-range provider.
+   * Only the chunks needed for the requested operations are fetched, so listing
+   * fields or rendering page 1 of a large remote PDF reads a small fraction of it.
+   * The provider is called synchronously (e.g. fs.readSync, or a synchronous
+   * XHR with a Range header inside a worker).
+   */
+  static async fromRangeProvider(
+    length: number,
+    provider: ByteRangeProvider,
+    password?: string
+  ): Promise<PdfForm> {
+    const module = await initPdfFiller();
+    const form = new PdfForm(module);
+
+    const success = form.instance.loadFromRangeProvider(length, provider, password ?? '');
+    if (!success) {
+      const error = form.instance.getLastError();
+      form.dispose();
+      throw new Error(`Failed to load PDF from range provider: ${error}`);
+    }
+
+    form._loaded = true;
+    return form;
   }
 
   /**
    * Create a new PdfForm instance and load a PDF from the virtual filesystem
-   * (useful when running in Node.js with files mounted to Emscripten FS)
+   * (useful when running in Node.js with files mounted to Emscripten FS).
+   * The file is read on demand, so it must stay in place while the form is open.
    */
   static async fromPath(path: string, password?: string): Promise<PdfForm> {
     const module = await initPdfFiller();
@@ -100,6 +145,7 @@ export class PdfForm {
     const success = form.instance.loadFromPath(path, password ?? '');
     if (!success) {
       const error = form.instance.getLastError();
+      form.dispose();
       throw new Error(`Failed to load PDF from path: ${error}`);
     }
 
@@ -107,6 +153,57 @@ export class PdfForm {
     return form;
   }
 
+  /**
+   * Create an independent copy of this document as it was originally loaded
+   * (edits made to this form are not carried over). The copy shares the
+   * source bytes instead of copying them and, if this form is unmodified,
+   * reuses its field table, which makes filling many copies of one template
+   * much cheaper than loading it each time. The xref is still parsed again.
+   * A form opened with `fromPath()` reopens that path instead, so after
+   * saving over it the copy starts from the saved file.
+   * Dispose the copy when done.
+   */
+  fork(): PdfForm {
+    this.ensureLoaded();
+    const instance = this.instance.fork();
+    if (instance === null) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to fork PDF: ${error}`);
+    }
+
+    const form = new PdfForm(this.module, instance);
+    form._loaded = true;
+    return form;
+  }
+
+  /**
+   * Compile the form's field table (names, types, values, geometry, options)
+   * into a compact blob. Store it next to the PDF and pass it to
+   * `loadTemplate()` on later loads of the same bytes to skip the AcroForm walk.
+   * Must be called before any field is modified.
+   */
+  compileTemplate(): Uint8Array {
+    this.ensureLoaded();
+    const result = this.instance.compileTemplate();
+    if (result === null) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to compile template: ${error}`);
+    }
+    return result;
+  }
+
+  /**
+   * Attach a blob produced by `compileTemplate()` for this PDF
+   */
+  loadTemplate(blob: Uint8Array): void {
+    this.ensureLoaded();
+    const success = this.instance.loadTemplate(blob);
+    if (!success) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to load template: ${error}`);
+    }
+  }
+
   /**
    * Get the number of pages in the document
    */
@@ -140,19 +237,85 @@ export class PdfForm {
   }
 
   /**
-   * Get all form fields in the document
+   * Get all form fields in the document.
+   * Pass a list of attribute groups to fetch only those properties; groups that
+   * are not requested are never read from the PDF or marshalled to JS
+   * (e.g. `getFields(['names'])` for autocomplete skips every option list).
+   */
+  getFields(): FormField[];
+  getFields<A extends FieldAttribute>(attributes: A[]): Partial<FormField>[];
+  getFields(attributes?: FieldAttribute[]): Partial<FormField>[] {
+    return (attributes ? this.getFieldTable(attributes) : this.getFieldTable()).toArray();
+  }
+
+  /**
+   * Get all form fields as a lazily materialized table. The whole table crosses
+   * the WASM boundary as a few typed arrays; FormField objects are only built
+   * for the rows that are accessed.
+   */
+  getFieldTable(): FieldTable<FormField>;
+  getFieldTable<A extends FieldAttribute>(attributes: A[]): FieldTable<Partial<FormField>>;
+  getFieldTable(attributes?: FieldAttribute[]): FieldTable<Partial<FormField>> {
+    this.ensureLoaded();
+    const attrs = attributes
+      ? attributes.reduce((mask, attr) => mask | FIELD_ATTRIBUTE_BITS[attr], 0)
+      : ALL_FIELD_ATTRIBUTES;
+    return new FieldTable(this.instance.getFormFieldColumns(attrs));
+  }
+
+  /**
+   * Get the form fields with a widget on one page. Only that page's widget
+   * annotations are read, so this does not walk the whole form; results are
+   * cached per page. Geometry is that of the field's widget on this page.
    */
-  getFields(): FormField[] {
+  getFieldsForPage(pageIndex: number): FormField[] {
     this.ensureLoaded();
-    return this.instance.getFormFields();
+    this.checkPageIndex(pageIndex);
+    return this.instance.getFormFieldsForPage(pageIndex);
   }
 
   /**
-   * Get a form field by name
+   * Get a form field by fully qualified name, or by partial name when only one
+   * field has it. Returns null if not found; throws if a partial name is ambiguous.
    */
   getField(name: string): FormField | null {
     this.ensureLoaded();
-    return this.instance.getFieldByName(name);
+    const field = this.instance.getFieldByName(name);
+    if (field === null) {
+      const error = this.instance.getLastError();
+      if (error.startsWith('Ambiguous')) {
+        throw new Error(error);
+      }
+    }
+    return field;
+  }
+
+  /**
+   * Get the position of every widget of a field. `FormField` geometry only
+   * describes the first widget; radio groups and repeated fields have more.
+   */
+  getFieldWidgets(name: string): WidgetRect[] {
+    this.ensureLoaded();
+    return this.instance.getFieldWidgets(name);
+  }
+
+  /**
+   * Get the fields with a widget containing the point (PDF points, origin at
+   * the bottom-left of the page), e.g. for click-to-edit
+   */
+  fieldsAt(pageIndex: number, x: number, y: number): FormField[] {
+    this.ensureLoaded();
+    this.checkPageIndex(pageIndex);
+    return this.instance.getFieldsAt(pageIndex, x, y);
+  }
+
+  /**
+   * Get the fields with a widget overlapping the rectangle (PDF points)
+   */
+  fieldsInRect(pageIndex: number, rect: { x: number; y: number; width: number; height: number }): FormField[] {
+    this.ensureLoaded();
+    this.checkPageIndex(pageIndex);
+    return this.instance.getFieldsInRect(pageIndex, rect.x, rect.y, rect.width, rect.height);
   }
 
   /**
@@ -180,17 +343,80 @@ export class PdfForm {
   }
 
   /**
-   * Set multiple field values at once
+   * Select options of a choice field by display text or export value. More
+   * than one value requires a multi-select list box; `[]` clears the selection.
    */
-  setFields(values: Record<string, string>): void {
+  setChoices(name: string, values: string[]): void {
     this.ensureLoaded();
-    const success = this.instance.setFieldValues(values);
+    const success = this.instance.setChoiceValues(name, values);
+    if (!success) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to set choices "${name}": ${error}`);
+    }
+  }
+
+  /**
+   * Set multiple field values at once. Values are typed: booleans for
+   * checkboxes, export values for radio groups, arrays for list boxes.
+   */
+  setFields(values: Record<string, FieldValue>): void {
+    this.ensureLoaded();
+    const success = this.applyPacked(values, false).every(code => code === 0);
     if (!success) {
       const error = this.instance.getLastError();
       throw new Error(`Failed to set fields: ${error}`);
     }
   }
 
+  /**
+   * Set many fields in one pass and report the outcome of each. Every name is
+   * resolved and every value validated before anything is written; with
+   * `{ atomic: true }` nothing is written unless all entries are valid.
+   * Does not throw for invalid entries - check the returned statuses.
+   */
+  applyFields(values: Record<string, FieldValue>, options: ApplyOptions = {}): FieldResult[] {
+    this.ensureLoaded();
+    const codes = this.applyPacked(values, options.atomic ?? false);
+    return Object.keys(values).map((name, i) => ({
+      name,
+      status: FIELD_STATUSES[codes[i] ?? 0] ?? 'not-applied',
+    }));
+  }
+
+  /**
+   * Get the field named `prefix` and every field below it (`prefix.*`), in
+   * name order; `''` returns all fields. Cost grows with the subtree size.
+   */
+  getFieldsUnder(prefix: string): FormField[] {
+    this.ensureLoaded();
+    return this.instance.getFieldsUnder(prefix);
+  }
+
+  /**
+   * Set fields below `prefix` by relative name, e.g.
+   * `setFieldsUnder('applicant.address', { line1: '...', city: '...' })`
+   */
+  setFieldsUnder(prefix: string, values: Record<string, string>): void {
+    this.ensureLoaded();
+    const success = this.instance.setFieldValuesUnder(prefix, values);
+    if (!success) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to set fields under "${prefix}": ${error}`);
+    }
+  }
+
+  /**
+   * Reset the field named `prefix` and every field below it to their default values
+   */
+  resetFieldsUnder(prefix: string): void {
+    this.ensureLoaded();
+    const success = this.instance.resetFieldsUnder(prefix);
+    if (!success) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to reset fields under "${prefix}": ${error}`);
+    }
+  }
+
   /**
    * Flatten the form (make fields non-editable, embed into page content)
    */
@@ -206,9 +432,9 @@ export class PdfForm {
   /**
    * Save the PDF to an ArrayBuffer
    */
-  save(): ArrayBuffer {
+  save(options?: SaveOptions): ArrayBuffer {
     this.ensureLoaded();
-    const result = this.instance.saveToArrayBuffer();
+    const result = this.instance.saveToArrayBuffer(options?.mode ?? 'auto');
     if (result === null) {
       const error = this.instance.getLastError();
       throw new Error(`Failed to save PDF: ${error}`);
@@ -219,8 +445,51 @@ export class PdfForm {
   /**
    * Save the PDF to a Uint8Array
    */
-  saveAsUint8Array(): Uint8Array {
-    return new Uint8Array(this.save());
+  saveAsUint8Array(options?: SaveOptions): Uint8Array {
+    return new Uint8Array(this.save(options));
+  }
+
+  /**
+   * Save the PDF by streaming it to `write` in chunks (about 1 MB each) as it
+   * is produced, so neither the WASM heap nor JS needs the full output at once.
+   * Each chunk is a fresh Uint8Array the callback may keep. Return `false`
+   * from the callback to abort the save.
+   */
+  saveToStream(write: (chunk: Uint8Array) => boolean | void, options?: SaveOptions): void {
+    this.ensureLoaded();
+    const success = this.instance.saveToSink(write, options?.mode ?? 'auto');
+    if (!success) {
+      const error = this.instance.getLastError();
+      throw new Error(`Failed to save PDF: ${error}`);
+    }
+  }
+
+  /**
+   * Save the PDF into a WHATWG WritableStream and close it. The native save
+   * is synchronous and can't wait for the stream, so the whole output is
+   * buffered in JS first. It is then written one chunk at a time, each write
+   * awaited (honouring the sink's backpressure) and each chunk released once
+   * written. To avoid the buffer, use saveToStream() with a synchronous sink.
+   */
+  async saveToWritable(stream: WritableStream<Uint8Array>, options?: SaveOptions): Promise<void> {
+    const writer = stream.getWriter();
+    try {
+      const chunks: Uint8Array[] = [];
+      this.saveToStream(chunk => {
+        chunks.push(chunk);
+      }, options);
+
+      let chunk: Uint8Array | undefined;
+      while ((chunk = chunks.shift()) !== undefined) {
+        await writer.write(chunk);
+      }
+      await writer.close();
+    } catch (err) {
+      await writer.abort(err);
+      throw err;
+    } finally {
+      writer.releaseLock();
+    }
   }
 
   /**
@@ -228,9 +497,7 @@ export class PdfForm {
    */
   renderPage(pageIndex: number, dpi = 150): Uint8Array {
     this.ensureLoaded();
-    if (pageIndex < 0 || pageIndex >= this.pageCount) {
-      throw new Error(`Page index ${pageIndex} out of range (0-${this.pageCount - 1})`);
-    }
+    this.checkPageIndex(pageIndex);
 
     const result = this.instance.renderPageToPng(pageIndex, dpi);
     if (result === null) {
@@ -240,6 +507,16 @@ export class PdfForm {
     return result;
   }
 
+  /**
+   * Release the native document. The form cannot be used afterwards.
+   */
+  dispose(): void {
+    if (this._disposed) return;
+    this.instance.delete();
+    this._disposed = true;
+    this._loaded = false;
+  }
+
   /**
    * Access the Emscripten filesystem for loading/saving files
    */
@@ -247,6 +524,15 @@ export class PdfForm {
     return this.module.FS;
   }
 
+  /**
+   * Memory held by the native field cache (names and values are interned in a
+   * per-document string arena)
+   */
+  get memoryStats(): MemoryStats {
+    this.ensureLoaded();
+    return this.instance.getMemoryStats();
+  }
+
   /**
    * Get the last error message from the native code
    */
@@ -254,6 +540,23 @@ export class PdfForm {
     return this.instance.getLastError();
   }
 
+  // Send a batch as one packed heap buffer; one status code per key of `values`
+  private applyPacked(values: Record<string, FieldValue>, atomic: boolean): Uint8Array {
+    const codes = withPackedFieldValues(this.module, values, (address, length) =>
+      this.instance.applyPackedFieldValues(address, length, atomic)
+    );
+    if (codes.length !== Object.keys(values).length) {
+      throw new Error(`Failed to set fields: ${this.instance.getLastError()}`);
+    }
+    return codes;
+  }
+
+  private checkPageIndex(pageIndex: number): void {
+    if (pageIndex < 0 || pageIndex >= this.pageCount) {
+      throw new Error(`Page index ${pageIndex} out of range (0-${this.pageCount - 1})`);
+    }
+  }
+
   private ensureLoaded(): void {
     if (!this._loaded) {
       throw new Error('PDF not loaded. Use PdfForm.fromArrayBuffer() or similar.');
@@ -262,7 +565,21 @@ export class PdfForm {
 }
 
 // Re-export types
-export type { FormField, FieldType } from './types';
+export { FieldTable } from './field-table';
+export type {
+  FormField,
+  FieldType,
+  FieldAttribute,
+  WidgetRect,
+  MemoryStats,
+  FieldValue,
+  FieldStatus,
+  FieldResult,
+  ApplyOptions,
+  ByteRangeProvider,
+  SaveMode,
+  SaveOptions,
+} from './types';
 
 // Default export for convenience
 export default PdfForm;
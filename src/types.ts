@@ -16,7 +16,7 @@ export interface FormField {
   name: string;
   /** Fully qualified name (parent.child) */
   fullName: string;
-  /** Current value */
+  /** Current value (for radio groups, the selected button's export value) */
   value: string;
   /** Default value */
   defaultValue: string;
@@ -38,32 +38,205 @@ export interface FormField {
   height: number;
   /** For choice fields: available options */
   options: string[];
-  /** For checkboxes/radios: value when checked */
+  /** For checkboxes/radios: value when checked (a radio group's first button) */
   exportValue: string;
   /** For checkboxes/radios: current state */
   isChecked: boolean;
 }
 
+/**
+ * Position of one widget (visual instance) of a field, in PDF points
+ */
+export interface WidgetRect {
+  /** Page index (0-based) */
+  pageIndex: number;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+/**
+ * Approximate memory held by a document's field cache, in bytes
+ */
+export interface MemoryStats {
+  fieldCount: number;
+  /** Distinct names, values and options in the string arena */
+  internedStrings: number;
+  /** String data held by the arena */
+  stringBytes: number;
+  /** String data interned, counting duplicates (the cost without interning) */
+  stringBytesRequested: number;
+  /** Bytes allocated for arena blocks */
+  arenaCapacity: number;
+  /** Field entries, option lists and object refs */
+  fieldTableBytes: number;
+  /** Name lookup index and arena hash set (estimated) */
+  indexBytes: number;
+}
+
+/**
+ * Attribute groups that can be requested from `PdfForm.getFields()`:
+ * - 'names': name, fullName
+ * - 'type': type, readOnly, required
+ * - 'value': value, defaultValue, exportValue, isChecked
+ * - 'options': options
+ * - 'geometry': pageIndex, x, y, width, height
+ */
+export type FieldAttribute = 'names' | 'type' | 'value' | 'options' | 'geometry';
+
+/** Bit for each attribute group (matches pdffiller::FieldAttr) */
+export const FIELD_ATTRIBUTE_BITS: Record<FieldAttribute, number> = {
+  names: 1 << 0,
+  type: 1 << 1,
+  value: 1 << 2,
+  options: 1 << 3,
+  geometry: 1 << 4,
+};
+
+export const ALL_FIELD_ATTRIBUTES = 0x1f;
+
+/**
+ * Columnar field export (pdffiller::FieldColumns). Columns for attribute groups
+ * not in `attrs` are empty.
+ */
+export interface FieldColumns {
+  count: number;
+  /** FIELD_ATTRIBUTE_BITS mask the columns were built with */
+  attrs: number;
+  /** Native FieldType code per field */
+  types: Uint8Array;
+  /** Read-only (1), required (2) and checked (4) bits per field */
+  flags: Uint8Array;
+  pageIndices: Int32Array;
+  /** x, y, width, height per field */
+  geometry: Float64Array;
+  /** UTF-8 string table; string i spans [stringOffsets[i], stringOffsets[i + 1]) */
+  strings: Uint8Array;
+  /** 5 strings per field (name, fullName, value, defaultValue, exportValue), then options */
+  stringOffsets: Uint32Array;
+  /** Field f's options are strings [optionOffsets[f], optionOffsets[f + 1]) */
+  optionOffsets: Uint32Array;
+}
+
+/**
+ * Value for a batch update (`PdfForm.setFields()` / `applyFields()`):
+ * - string: text, a choice option (text or export value), or a radio
+ *   button's export value ("Off" or "" clears the group, anything else is
+ *   an invalid value); other strings set checkboxes by truthiness
+ * - boolean: checkbox or radio state
+ * - number: text or choice, written as its shortest decimal form
+ * - string[]: choice selection (more than one needs a multi-select list box)
+ *
+ * null and undefined are passed as "", which clears a text or choice field,
+ * unchecks a checkbox and turns a radio group off (where it allows that).
+ */
+export type FieldValue = string | boolean | number | string[];
+
+/**
+ * Outcome of one entry of a batch update (`PdfForm.applyFields()`):
+ * - 'ok': applied
+ * - 'not-found': no field with that name
+ * - 'ambiguous': partial name shared by several fields
+ * - 'type-mismatch': field can't take that kind of value (e.g. a boolean for text, or a signature)
+ * - 'invalid-value': not a choice field's option or a radio group's export
+ *   value, a non-finite number, or unchecking a radio group that must keep
+ *   one button on
+ * - 'unavailable': field no longer present in the document
+ * - 'not-applied': valid, but an atomic batch had failures
+ * - 'write-failed': valid, but the PDF library refused the write
+ */
+export type FieldStatus =
+  | 'ok'
+  | 'not-found'
+  | 'ambiguous'
+  | 'type-mismatch'
+  | 'invalid-value'
+  | 'unavailable'
+  | 'not-applied'
+  | 'write-failed';
+
+/** Index is the native pdffiller::FieldStatus code */
+export const FIELD_STATUSES: FieldStatus[] = [
+  'ok',
+  'not-found',
+  'ambiguous',
+  'type-mismatch',
+  'invalid-value',
+  'unavailable',
+  'not-applied',
+  'write-failed',
+];
+
+export interface FieldResult {
+  name: string;
+  status: FieldStatus;
+}
+
+export interface ApplyOptions {
+  /** Apply nothing unless every entry is valid (default: false) */
+  atomic?: boolean;
+}
+
+/**
+ * How the document is serialized on save:
+ * - 'auto': full rewrite if modified, otherwise the original bytes
+ * - 'incremental': original bytes plus an appended update with only the
+ *   changed objects (fast for large files, keeps existing signatures valid)
+ * - 'rewrite': always re-serialize every object
+ */
+export type SaveMode = 'auto' | 'incremental' | 'rewrite';
+
+export interface SaveOptions {
+  /** Serialization mode (default: 'auto') */
+  mode?: SaveMode;
+}
+
+/**
+ * Synchronously returns `length` bytes starting at `offset`, or null on failure
+ */
+export type ByteRangeProvider = (offset: number, length: number) => Uint8Array | null;
+
 /**
  * Low-level instance returned by the WASM module
  */
 export interface PdfFillerInstance {
-  loadFromArrayBuffer(data: ArrayBuffer, password: string): boolean;
+  loadFromArrayBuffer(data: ArrayBuffer | ArrayBufferView, password: string): boolean;
+  loadFromRangeProvider(length: number, provider: ByteRangeProvider, password: string): boolean;
   loadFromPath(path: string, password: string): boolean;
+  fork(): PdfFillerInstance | null;
+  compileTemplate(): Uint8Array | null;
+  loadTemplate(blob: Uint8Array): boolean;
   getPageCount(): number;
   getTitle(): string;
   getAuthor(): string;
   hasAcroForm(): boolean;
-  getFormFields(): FormField[];
+  getFormFields(attrs: number): Partial<FormField>[];
+  getFormFieldColumns(attrs: number): FieldColumns;
+  getFormFieldsForPage(pageIndex: number): FormField[];
   getFieldByName(name: string): FormField | null;
+  getFieldWidgets(name: string): WidgetRect[];
+  getFieldsAt(pageIndex: number, x: number, y: number): FormField[];
+  getFieldsInRect(pageIndex: number, x: number, y: number, width: number, height: number): FormField[];
   setFieldValue(name: string, value: string): boolean;
   setCheckboxValue(name: string, checked: boolean): boolean;
-  setFieldValues(values: Record<string, string>): boolean;
+  setChoiceValues(name: string, values: string[]): boolean;
+  setFieldValues(values: Record<string, FieldValue>): boolean;
+  applyFieldValues(values: Record<string, FieldValue>, atomic: boolean): Uint8Array;
+  /** Packed batch at a heap address (see field-buffer.ts); empty if malformed */
+  applyPackedFieldValues(address: number, length: number, atomic: boolean): Uint8Array;
+  getFieldsUnder(prefix: string): FormField[];
+  setFieldValuesUnder(prefix: string, values: Record<string, string>): boolean;
+  resetFieldsUnder(prefix: string): boolean;
   flattenForm(): boolean;
-  saveToArrayBuffer(): ArrayBuffer | null;
-  saveToPath(path: string): boolean;
+  saveToArrayBuffer(mode: SaveMode): ArrayBuffer | null;
+  saveToSink(callback: (chunk: Uint8Array) => boolean | void, mode: SaveMode): boolean;
+  saveToPath(path: string, mode: SaveMode): boolean;
   renderPageToPng(pageIndex: number, dpi: number): Uint8Array | null;
+  getMemoryStats(): MemoryStats;
   getLastError(): string;
+  /** Free the underlying C++ object (embind) */
+  delete(): void;
 }
 
 /**
@@ -86,6 +259,8 @@ export interface PdfFillerModule {
   PdfFiller: new () => PdfFillerInstance;
   FS: EmscriptenFS;
   HEAPU8: Uint8Array;
+  _malloc: (size: number) => number;
+  _free: (address: number) => void;
   ccall: (
     name: string,
     returnType: string,
@@ -0,0 +1,172 @@
+/**
+ * Shared fixtures for tests and benchmarks
+ */
+
+/**
+ * Grow a PDF to roughly `targetSize` bytes without changing its content:
+ * a comment block is appended after the original %%EOF, followed by a new
+ * trailer that points back at the original startxref offset.
+ */
+export function padPdf(data: Uint8Array, targetSize: number): Uint8Array {
+  const tail = Buffer.from(data.subarray(Math.max(0, data.length - 1024))).toString('latin1');
+  const matches = [...tail.matchAll(/startxref\s+(\d+)/g)];
+  const startXref = matches[matches.length - 1][1];
+  const trailer = Buffer.from(`\nstartxref\n${startXref}\n%%EOF\n`, 'latin1');
+
+  const padLength = Math.max(0, targetSize - data.length - trailer.length);
+  const out = new Uint8Array(data.length + padLength + trailer.length);
+  out.set(data, 0);
+  out.fill(0x20, data.length, data.length + padLength);
+  if (padLength > 0) {
+    out[data.length] = 0x0a; // \n
+    out[data.length + 1] = 0x25; // %
+  }
+  out.set(trailer, data.length + padLength);
+  return out;
+}
+
+export interface Rect {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+export interface SyntheticForm {
+  data: Uint8Array;
+  /** Widget rects of the radio group "choice", one per export value in `exportValues` */
+  radioRects: Rect[];
+  exportValues: string[];
+  /** Widget rects of the text field "copy", which is shown twice */
+  copyRects: Rect[];
+}
+
+// Number ASCII-only object bodies 1..n (object 1 is the catalog) and add an xref table
+function assemblePdf(objects: string[]): Uint8Array {
+  let out = '%PDF-1.7\n';
+  const offsets: number[] = [];
+  objects.forEach((body, i) => {
+    offsets.push(out.length);
+    out += `${i + 1} 0 obj\n${body}\nendobj\n`;
+  });
+  const startXref = out.length;
+  out += `xref\n0 ${objects.length + 1}\n0000000000 65535 f \n`;
+  for (const offset of offsets) out += `${String(offset).padStart(10, '0')} 00000 n \n`;
+  out += `trailer\n<< /Size ${objects.length + 1} /Root 1 0 R >>\nstartxref\n${startXref}\n%%EOF\n`;
+  return new Uint8Array(Buffer.from(out, 'latin1'));
+}
+
+const pdfRect = (r: Rect) => `[${r.x} ${r.y} ${r.x + r.width} ${r.y + r.height}]`;
+
+/**
+ * A one-page form with a known layout:
+ * - `rows` parent fields row0..row{rows-1}, each with the text fields
+ *   name, amount and date (the same partial names on every row)
+ * - a radio group "choice" with one widget per export value
+ * - a text field "copy" with two widgets
+ * - a multi-select list box "colors" with the options Red, Green and Blue
+ *   (export values r, g and b)
+ */
+export function makeFormPdf(rows: number): SyntheticForm {
+  const objects: string[] = [];
+  const add = (body: string) => objects.push(body);
+  const page = 3;
+  const fields: number[] = [];
+  const annots: number[] = [];
+
+  add(''); // catalog, filled in last
+  add(`<< /Type /Pages /Kids [${page} 0 R] /Count 1 >>`);
+  add(''); // page, filled in last
+  const appearance = add('<< /Length 0 >>\nstream\n\nendstream');
+
+  const columns = ['name', 'amount', 'date'];
+  for (let row = 0; row < rows; row++) {
+    const parent = add('');
+    const kids = columns.map((column, c) => {
+      const rect = { x: 50 + c * 150, y: 700 - row * 14, width: 140, height: 12 };
+      const kid = add(
+        `<< /FT /Tx /T (${column}) /Parent ${parent} 0 R /Type /Annot /Subtype /Widget ` +
+          `/Rect ${pdfRect(rect)} /P ${page} 0 R >>`
+      );
+      annots.push(kid);
+      return kid;
+    });
+    objects[parent - 1] = `<< /T (row${row}) /Kids [${kids.map(k => `${k} 0 R`).join(' ')}] >>`;
+    fields.push(parent);
+  }
+
+  // Radio group: NoToggleToOff | Radio; each widget's on-state is its /AP /N key other than /Off
+  const exportValues = ['small', 'medium', 'large'];
+  const radioRects = exportValues.map((_, i) => ({ x: 50 + i * 40, y: 60, width: 20, height: 20 }));
+  const radio = add('');
+  const radioKids = exportValues.map((value, i) => {
+    const kid = add(
+      `<< /Type /Annot /Subtype /Widget /Parent ${radio} 0 R /Rect ${pdfRect(radioRects[i]!)} ` +
+        `/P ${page} 0 R /AS /Off /AP << /N << /${value} ${appearance} 0 R /Off ${appearance} 0 R >> >> >>`
+    );
+    annots.push(kid);
+    return kid;
+  });
+  objects[radio - 1] =
+    `<< /FT /Btn /Ff 49152 /T (choice) /V /Off /Kids [${radioKids.map(k => `${k} 0 R`).join(' ')}] >>`;
+  fields.push(radio);
+
+  const copyRects = [
+    { x: 300, y: 60, width: 100, height: 20 },
+    { x: 420, y: 60, width: 100, height: 20 },
+  ];
+  const copy = add('');
+  const copyKids = copyRects.map(rect => {
+    const kid = add(`<< /Type /Annot /Subtype /Widget /Parent ${copy} 0 R /Rect ${pdfRect(rect)} /P ${page} 0 R >>`);
+    annots.push(kid);
+    return kid;
+  });
+  objects[copy - 1] = `<< /FT /Tx /T (copy) /Kids [${copyKids.map(k => `${k} 0 R`).join(' ')}] >>`;
+  fields.push(copy);
+
+  // List box (no Combo flag) with MultiSelect; /Opt pairs are [export value, display text]
+  const colors = add(
+    `<< /FT /Ch /Ff 2097152 /T (colors) /Opt [[(r) (Red)] [(g) (Green)] [(b) (Blue)]] ` +
+      `/Type /Annot /Subtype /Widget /Rect ${pdfRect({ x: 50, y: 20, width: 120, height: 30 })} /P ${page} 0 R >>`
+  );
+  annots.push(colors);
+  fields.push(colors);
+
+  objects[0] =
+    `<< /Type /Catalog /Pages 2 0 R /AcroForm << /Fields [${fields.map(f => `${f} 0 R`).join(' ')}] >> >>`;
+  objects[page - 1] =
+    `<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Annots [${annots.map(a => `${a} 0 R`).join(' ')}] >>`;
+
+  return { data: assemblePdf(objects), radioRects, exportValues, copyRects };
+}
+
+/**
+ * Map each export value of a radio group to the /AS of the widget whose
+ * normal appearance has that on-state, reading the last revision of each
+ * object in a saved (uncompressed) PDF.
+ */
+export function radioAppearanceStates(pdf: Uint8Array, exportValues: string[]): Record<string, string> {
+  const states: Record<string, string> = {};
+  for (const body of Buffer.from(pdf).toString('latin1').split('endobj')) {
+    const as = /\/AS\s*\/(\w+)/.exec(body);
+    if (!as) continue;
+    for (const value of exportValues) {
+      if (new RegExp(`/N\\s*<<[^>]*/${value}\\b`).test(body)) states[value] = as[1]!;
+    }
+  }
+  return states;
+}
+
+/**
+ * Selected option indices (/I) of the choice field `name` in the last
+ * revision of a saved (uncompressed) PDF
+ */
+export function choiceSelection(pdf: Uint8Array, name: string): number[] {
+  let selection: number[] = [];
+  for (const body of Buffer.from(pdf).toString('latin1').split('endobj')) {
+    if (!body.includes(`/T (${name})`)) continue;
+    const indices = /\/I\s*\[([\d\s]*)\]/.exec(body);
+    selection = indices ? indices[1]!.trim().split(/\s+/).filter(Boolean).map(Number) : [];
+  }
+  return selection;
+}
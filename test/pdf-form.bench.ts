@@ -0,0 +1,190 @@
+import { describe, bench, beforeAll } from 'vitest';
+import { PdfForm, initPdfFiller } from '../src/index';
+import * as fs from 'fs';
+import * as path from 'path';
+import { ALL_FIELD_ATTRIBUTES, type PdfFillerInstance } from '../src/types';
+import { padPdf, makeFormPdf } from './helpers';
+
+// Skip benchmarks if WASM module not built
+const wasmPath = path.join(__dirname, '../dist/pdf-filler.wasm');
+const wasmExists = fs.existsSync(wasmPath);
+
+// Test PDF path
+const testPdfPath = path.join(__dirname, 'hc001.pdf');
+const testPdfExists = fs.existsSync(testPdfPath);
+
+// The embind handle behind a form, for baselines on the native object API
+const nativeInstance = (form: PdfForm) => (form as unknown as { instance: PdfFillerInstance }).instance;
+
+describe.skipIf(!wasmExists || !testPdfExists)('loading', () => {
+  const original = testPdfExists ? new Uint8Array(fs.readFileSync(testPdfPath)) : new Uint8Array();
+  const sizes = [1, 4, 16, 64].map(mb => mb * 1024 * 1024);
+  const padded = new Map(sizes.map(size => [size, testPdfExists ? padPdf(original, size) : original]));
+
+  beforeAll(async () => {
+    await initPdfFiller();
+  });
+
+  // Load time should grow linearly with input size (one bulk copy into the heap)
+  for (const size of sizes) {
+    bench(`fromUint8Array ${size / (1024 * 1024)} MB`, async () => {
+      const form = await PdfForm.fromUint8Array(padded.get(size)!);
+      form.dispose();
+    });
+  }
+});
+
+describe.skipIf(!wasmExists || !testPdfExists)('output transfer', () => {
+  const original = testPdfExists ? new Uint8Array(fs.readFileSync(testPdfPath)) : new Uint8Array();
+  const large = testPdfExists ? padPdf(original, 16 * 1024 * 1024) : original;
+  let form: PdfForm;
+
+  beforeAll(async () => {
+    form = await PdfForm.fromUint8Array(large);
+  });
+
+  // Baseline: a plain JS copy of the same number of bytes
+  bench('memcpy baseline 16 MB (Uint8Array.slice)', () => {
+    large.slice();
+  });
+
+  // Unmodified save copies the source bytes, so it should track the baseline
+  bench('save 16 MB', () => {
+    form.save();
+  });
+
+  bench('renderPage 150 dpi', () => {
+    form.renderPage(0, 150);
+  });
+});
+
+describe.skipIf(!wasmExists || !testPdfExists)('template filling', () => {
+  const original = testPdfExists ? new Uint8Array(fs.readFileSync(testPdfPath)) : new Uint8Array();
+  let template: PdfForm;
+  let fieldName: string;
+
+  beforeAll(async () => {
+    template = await PdfForm.fromUint8Array(original);
+    fieldName = template.getFields().find(f => f.type === 'text')!.fullName;
+  });
+
+  bench('load + fill + save', async () => {
+    const form = await PdfForm.fromUint8Array(original);
+    form.setField(fieldName, 'Benchmark Value');
+    form.save();
+    form.dispose();
+  });
+
+  bench('fork + fill + save', () => {
+    const form = template.fork();
+    form.setField(fieldName, 'Benchmark Value');
+    form.save();
+    form.dispose();
+  });
+});
+
+describe.skipIf(!wasmExists || !testPdfExists)('field enumeration', () => {
+  let form: PdfForm;
+
+  beforeAll(async () => {
+    form = await PdfForm.fromUint8Array(new Uint8Array(fs.readFileSync(testPdfPath)));
+    form.getFields();
+  });
+
+  // Baseline: one embind object per field, built property by property
+  bench('getFormFields (object path)', () => {
+    nativeInstance(form).getFormFields(ALL_FIELD_ATTRIBUTES);
+  });
+
+  // Columnar export: one transfer, objects built in JS
+  bench('getFields', () => {
+    form.getFields();
+  });
+
+  bench('getFieldTable + fullName column', () => {
+    const table = form.getFieldTable(['names']);
+    for (let i = 0; i < table.length; i++) {
+      table.fullName(i);
+    }
+  });
+});
+
+describe.skipIf(!wasmExists)('field enumeration (6000 fields)', () => {
+  let form: PdfForm;
+
+  beforeAll(async () => {
+    form = await PdfForm.fromUint8Array(makeFormPdf(2000).data);
+    form.getFields();
+  });
+
+  bench('getFormFields (object path)', () => {
+    nativeInstance(form).getFormFields(ALL_FIELD_ATTRIBUTES);
+  });
+
+  bench('getFields', () => {
+    form.getFields();
+  });
+});
+
+describe.skipIf(!wasmExists || !testPdfExists)('batch filling', () => {
+  let form: PdfForm;
+  const textValues: Record<string, string> = {};
+
+  beforeAll(async () => {
+    form = await PdfForm.fromUint8Array(new Uint8Array(fs.readFileSync(testPdfPath)));
+    for (const f of form.getFields()) {
+      if (f.type === 'text' && !f.readOnly) textValues[f.fullName] = `Value ${f.name}`;
+    }
+  });
+
+  // One packed heap buffer per batch
+  bench('setFields, every text field', () => {
+    form.setFields(textValues);
+  });
+});
+
+describe.skipIf(!wasmExists)('adopted field tables (6000 fields)', () => {
+  const { data } = makeFormPdf(2000);
+  let source: PdfForm;
+  let blob: Uint8Array;
+  const values: Record<string, string> = {};
+
+  beforeAll(async () => {
+    source = await PdfForm.fromUint8Array(data);
+    for (const f of source.getFields()) {
+      if (f.type === 'text') values[f.fullName] = `Value ${f.fullName}`;
+    }
+    blob = source.compileTemplate();
+  });
+
+  bench('fresh load + getFields', async () => {
+    const form = await PdfForm.fromUint8Array(data);
+    form.getFields();
+    form.dispose();
+  });
+
+  bench('load + loadTemplate + getFields', async () => {
+    const form = await PdfForm.fromUint8Array(data);
+    form.loadTemplate(blob);
+    form.getFields();
+    form.dispose();
+  });
+
+  bench('fork + getFields', () => {
+    const form = source.fork();
+    form.getFields();
+    form.dispose();
+  });
+
+  bench('fresh load + setFields', async () => {
+    const form = await PdfForm.fromUint8Array(data);
+    form.setFields(values);
+    form.dispose();
+  });
+
+  bench('fork + setFields', () => {
+    const form = source.fork();
+    form.setFields(values);
+    form.dispose();
+  });
+});
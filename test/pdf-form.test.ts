@@ -2,6 +2,15 @@ import { describe, it, expect, beforeAll } from 'vitest';
 import { PdfForm, initPdfFiller } from '../src/index';
 import * as fs from 'fs';
 import * as path from 'path';
+import {
+  FIELD_ATTRIBUTE_BITS,
+  ALL_FIELD_ATTRIBUTES,
+  type FieldValue,
+  type PdfFillerInstance,
+  type PdfFillerModule,
+} from '../src/types';
+import { withPackedFieldValues } from '../src/field-buffer';
+import { padPdf, makeFormPdf, radioAppearanceStates, choiceSelection } from './helpers';
 
 // Skip tests if WASM module not built
 const wasmPath = path.join(__dirname, '../dist/pdf-filler.wasm');
@@ -11,6 +20,9 @@ const wasmExists = fs.existsSync(wasmPath);
 const testPdfPath = path.join(__dirname, 'hc001.pdf');
 const testPdfExists = fs.existsSync(testPdfPath);
 
+// The embind handle behind a form, for checks against the native object API
+const nativeInstance = (form: PdfForm) => (form as unknown as { instance: PdfFillerInstance }).instance;
+
 describe.skipIf(!wasmExists)('PdfForm', () => {
   beforeAll(async () => {
     await initPdfFiller();
@@ -29,6 +41,214 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       const invalidData = new Uint8Array([0, 1, 2, 3]);
       await expect(PdfForm.fromUint8Array(invalidData)).rejects.toThrow();
     });
+
+    it('should load from a filesystem path', async () => {
+      const { FS } = await initPdfFiller();
+      const { data } = makeFormPdf(2);
+      FS.writeFile('/from-path.pdf', data);
+
+      const form = await PdfForm.fromPath('/from-path.pdf');
+      const expected = await PdfForm.fromUint8Array(data);
+      expect(form.getFields()).toEqual(expected.getFields());
+      form.dispose();
+      FS.unlink('/from-path.pdf');
+
+      await expect(PdfForm.fromPath('/missing.pdf')).rejects.toThrow();
+    });
+
+    it('should save over the file it was loaded from', async () => {
+      const { FS } = await initPdfFiller();
+      FS.mkdir('/save-over');
+      FS.writeFile('/save-over/form.pdf', makeFormPdf(1).data);
+      // An unrelated file with the old fixed temp name must survive the save
+      FS.writeFile('/save-over/form.pdf.tmp', new Uint8Array([1, 2, 3]));
+
+      const form = await PdfForm.fromPath('/save-over/form.pdf');
+      form.setField('copy', 'Saved over');
+      expect(nativeInstance(form).saveToPath('/save-over/form.pdf', 'auto')).toBe(true);
+
+      // The source is still readable, and a fork reopens the saved file
+      expect(form.getField('row0.name')?.value).toBe('');
+      const fork = form.fork();
+      expect(fork.getField('copy')?.value).toBe('Saved over');
+      fork.dispose();
+      form.dispose();
+
+      const reloaded = await PdfForm.fromPath('/save-over/form.pdf');
+      expect(reloaded.getField('copy')?.value).toBe('Saved over');
+      reloaded.dispose();
+
+      expect(Array.from(FS.readFile('/save-over/form.pdf.tmp'))).toEqual([1, 2, 3]);
+      expect(FS.readdir('/save-over').sort()).toEqual(['.', '..', 'form.pdf', 'form.pdf.tmp']);
+      FS.unlink('/save-over/form.pdf');
+      FS.unlink('/save-over/form.pdf.tmp');
+      FS.rmdir('/save-over');
+    });
+  });
+
+  describe.skipIf(!testPdfExists)('lazy loading', () => {
+    it('should list fields of a large file while reading only a few chunks', async () => {
+      const original = new Uint8Array(fs.readFileSync(testPdfPath));
+      const data = padPdf(original, 100 * 1024 * 1024);
+
+      let bytesRead = 0;
+      const form = await PdfForm.fromRangeProvider(data.length, (offset, length) => {
+        bytesRead += length;
+        return data.subarray(offset, offset + length);
+      });
+
+      const fields = form.getFields();
+      expect(fields.length).toBeGreaterThan(0);
+      expect(bytesRead).toBeLessThan(1024 * 1024);
+      form.dispose();
+    });
+
+    it('should fail cleanly when the provider returns no data', async () => {
+      await expect(PdfForm.fromRangeProvider(1024, () => null)).rejects.toThrow();
+    });
+  });
+
+  describe('multi-widget fields', () => {
+    it('should report and hit-test every widget of a radio group and a repeated field', async () => {
+      const { data, radioRects, copyRects } = makeFormPdf(3);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const cases: [string, typeof radioRects][] = [['choice', radioRects], ['copy', copyRects]];
+      for (const [name, rects] of cases) {
+        expect(form.getFieldWidgets(name)).toEqual(rects.map(r => ({ pageIndex: 0, ...r })));
+        for (const r of rects) {
+          const hits = form.fieldsAt(0, r.x + r.width / 2, r.y + r.height / 2);
+          expect(hits.map(f => f.fullName)).toEqual([name]);
+        }
+      }
+
+      // A band covering both multi-widget fields returns each of them once
+      const band = form.fieldsInRect(0, { x: 0, y: 55, width: 612, height: 30 });
+      expect(band.map(f => f.fullName).sort()).toEqual(['choice', 'copy']);
+    });
+
+    it('should hit-test non-finite and huge coordinates without trapping', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(3).data);
+      const all = form.getFields().map(f => f.fullName).sort();
+
+      for (const v of [NaN, Infinity, -Infinity, 1e300, -1e300]) {
+        expect(form.fieldsAt(0, v, v)).toEqual([]);
+        expect(form.fieldsAt(0, v, 100)).toEqual([]);
+        expect(form.fieldsInRect(0, { x: v, y: v, width: 10, height: 10 })).toEqual([]);
+      }
+      expect(form.fieldsInRect(0, { x: 0, y: 0, width: NaN, height: 100 })).toEqual([]);
+
+      // Unbounded and huge rects cover the whole page
+      const everything = [
+        { x: 0, y: 0, width: Infinity, height: Infinity },
+        { x: -1e300, y: -1e300, width: 2e300, height: 2e300 },
+      ];
+      for (const rect of everything) {
+        expect(form.fieldsInRect(0, rect).map(f => f.fullName).sort()).toEqual(all);
+      }
+    });
+  });
+
+  describe('multi-select choice fields', () => {
+    // Each step's selection, read back from /I after an incremental save
+    const selectionAfter = async (form: PdfForm) => {
+      const saved = form.saveAsUint8Array({ mode: 'incremental' });
+      const reloaded = await PdfForm.fromUint8Array(saved);
+      const value = reloaded.getField('colors')?.value;
+      reloaded.dispose();
+      return { indices: choiceSelection(saved, 'colors'), value };
+    };
+
+    it('should select several options by text or export value', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+
+      expect(form.applyFields({ colors: ['Red', 'b'] })[0]?.status).toBe('ok');
+      expect(await selectionAfter(form)).toEqual({ indices: [0, 2], value: 'Red' });
+
+      form.setChoices('colors', ['g', 'Blue']);
+      expect(await selectionAfter(form)).toEqual({ indices: [1, 2], value: 'Green' });
+    });
+
+    it('should replace the previous selection', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+      form.setFields({ colors: ['Red', 'Green'] });
+
+      form.setFields({ colors: ['Blue'] });
+      expect(await selectionAfter(form)).toEqual({ indices: [2], value: 'Blue' });
+
+      // A single string selects exactly that option too
+      form.setFields({ colors: ['Red', 'Green'] });
+      form.setFields({ colors: 'Blue' });
+      expect(await selectionAfter(form)).toEqual({ indices: [2], value: 'Blue' });
+      form.setField('colors', 'g');
+      expect(await selectionAfter(form)).toEqual({ indices: [1], value: 'Green' });
+    });
+
+    it('should clear the selection with an empty list', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+      form.setFields({ colors: ['Red', 'Blue'] });
+
+      expect(form.applyFields({ colors: [] })[0]?.status).toBe('ok');
+      expect(form.getField('colors')?.value).toBe('');
+      expect((await selectionAfter(form)).indices).toEqual([]);
+    });
+
+    it('should clear fields set to null or undefined', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+      const filled = { colors: ['Red', 'Blue'], copy: 'Text' };
+      const cleared = { colors: null, copy: undefined } as unknown as Record<string, FieldValue>;
+
+      // Packed path (applyFields) and embind object path (applyFieldValues)
+      form.setFields(filled);
+      expect(form.applyFields(cleared).map(r => r.status)).toEqual(['ok', 'ok']);
+      expect(await selectionAfter(form)).toEqual({ indices: [], value: '' });
+      expect(form.getField('copy')?.value).toBe('');
+
+      form.setFields(filled);
+      expect(Array.from(nativeInstance(form).applyFieldValues(cleared, false))).toEqual([0, 0]);
+      expect(await selectionAfter(form)).toEqual({ indices: [], value: '' });
+      expect(form.getField('copy')?.value).toBe('');
+    });
+
+    it('should leave the selection alone when a value is not an option', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+      form.setFields({ colors: ['Red', 'Blue'] });
+
+      expect(form.applyFields({ colors: ['Red', 'Purple'] })[0]?.status).toBe('invalid-value');
+      expect(await selectionAfter(form)).toEqual({ indices: [0, 2], value: 'Red' });
+    });
+  });
+
+  describe('field cache memory', () => {
+    it('should store each repeated name once', async () => {
+      // 200 rows of name/amount/date: the partial names repeat on every row
+      const form = await PdfForm.fromUint8Array(makeFormPdf(200).data);
+      const fields = form.getFields();
+
+      const strings = fields.flatMap(f => [f.name, f.fullName, f.value, f.defaultValue, f.exportValue, ...f.options]);
+      const total = strings.reduce((n, s) => n + Buffer.byteLength(s), 0);
+      const distinct = [...new Set(strings)].reduce((n, s) => n + Buffer.byteLength(s), 0);
+
+      const stats = form.memoryStats;
+      expect(stats.stringBytesRequested).toBeGreaterThanOrEqual(total);
+      expect(stats.stringBytes).toBeLessThanOrEqual(distinct);
+      expect(stats.stringBytes).toBeLessThan(stats.stringBytesRequested * 0.75);
+    });
+
+    it('should not grow without bound when a field is filled and read repeatedly', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(10).data);
+      form.getFields();
+      const baseline = form.memoryStats.stringBytes;
+
+      const padding = 'x'.repeat(200);
+      for (let i = 0; i < 5000; i++) {
+        form.setField('copy', `${i} ${padding}`);
+        expect(form.getField('copy')?.value).toBe(`${i} ${padding}`);
+      }
+
+      // About 1 MB of distinct values went through the table
+      expect(form.memoryStats.stringBytes).toBeLessThan(baseline + 256 * 1024);
+    });
   });
 
   describe.skipIf(!testPdfExists)('form fields', () => {
@@ -47,6 +267,88 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       }
     });
 
+    it('should return only the requested attribute groups', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const full = form.getFields();
+      const names = form.getFields(['names']);
+      expect(names.length).toBe(full.length);
+      expect(Object.keys(names[0]).sort()).toEqual(['fullName', 'name']);
+      expect(names.map(f => f.fullName)).toEqual(full.map(f => f.fullName));
+
+      const geometry = form.getFields(['names', 'geometry']);
+      expect(geometry[0].x).toBe(full[0].x);
+      expect(geometry[0].options).toBeUndefined();
+      expect(geometry[0].value).toBeUndefined();
+    });
+
+    it('should expose the columnar field table', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      // getFields() decodes the same columns, so check them against the native object path
+      const fields = nativeInstance(form).getFormFields(ALL_FIELD_ATTRIBUTES);
+      const table = form.getFieldTable();
+      expect(table.length).toBe(fields.length);
+      expect(table.toArray()).toEqual(fields);
+      expect(form.getFieldTable(['names', 'value']).toArray()).toEqual(
+        nativeInstance(form).getFormFields(FIELD_ATTRIBUTE_BITS.names | FIELD_ATTRIBUTE_BITS.value)
+      );
+      for (let i = 0; i < table.length; i++) {
+        expect(table.fullName(i)).toBe(fields[i].fullName);
+        expect(table.type(i)).toBe(fields[i].type);
+      }
+      expect(table.get(0)).toBe(table.get(0));
+    });
+
+    it('should list the fields of a single page', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const all = form.getFields();
+      let total = 0;
+      for (let page = 0; page < form.pageCount; page++) {
+        const fields = form.getFieldsForPage(page);
+        for (const field of fields) {
+          expect(field.pageIndex).toBe(page);
+          expect(all.some(f => f.fullName === field.fullName)).toBe(true);
+        }
+        total += fields.length;
+      }
+      expect(total).toBeGreaterThan(0);
+      expect(() => form.getFieldsForPage(form.pageCount)).toThrow();
+    });
+
+    it('should hit-test field widgets', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const field = form.getFields().find(f => f.width > 0 && f.height > 0)!;
+      const widgets = form.getFieldWidgets(field.fullName);
+      expect(widgets.length).toBeGreaterThanOrEqual(1);
+      expect(widgets[0].pageIndex).toBe(field.pageIndex);
+      expect(widgets[0].x).toBeCloseTo(field.x);
+
+      const hits = form.fieldsAt(field.pageIndex, field.x + field.width / 2, field.y + field.height / 2);
+      expect(hits.map(f => f.fullName)).toContain(field.fullName);
+
+      const page = form.fieldsInRect(field.pageIndex, { x: -1e6, y: -1e6, width: 2e6, height: 2e6 });
+      expect(page.map(f => f.fullName)).toContain(field.fullName);
+      expect(form.fieldsAt(field.pageIndex, -1e6, -1e6)).toEqual([]);
+    });
+
+    it('should report field cache memory', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const stats = form.memoryStats;
+      expect(stats.fieldCount).toBe(fields.length);
+      expect(stats.internedStrings).toBeGreaterThan(0);
+      expect(stats.arenaCapacity).toBeGreaterThanOrEqual(stats.stringBytes);
+    });
+
     it('should find text fields', async () => {
       const data = fs.readFileSync(testPdfPath);
       const form = await PdfForm.fromUint8Array(data);
@@ -57,6 +359,35 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       expect(textFields.length).toBeGreaterThan(0);
     });
 
+    it('should look up every field by its fully qualified name', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      for (const field of form.getFields()) {
+        expect(form.getField(field.fullName)?.fullName).toBe(field.fullName);
+      }
+      expect(form.getField('no.such.field')).toBeNull();
+    });
+
+    it('should resolve unique partial names and reject ambiguous ones', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const fullNames = new Set(fields.map(f => f.fullName));
+      const counts = new Map<string, number>();
+      for (const f of fields) counts.set(f.name, (counts.get(f.name) ?? 0) + 1);
+
+      for (const [name, count] of counts) {
+        if (fullNames.has(name)) continue;
+        if (count === 1) {
+          expect(form.getField(name)?.name).toBe(name);
+        } else {
+          expect(() => form.getField(name)).toThrow(/Ambiguous/);
+        }
+      }
+    });
+
     it('should find checkbox fields', async () => {
       const data = fs.readFileSync(testPdfPath);
       const form = await PdfForm.fromUint8Array(data);
@@ -81,6 +412,151 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       expect(() => form.setField(textField!.fullName, 'Test Value')).not.toThrow();
     });
 
+    it('should select choice options by value', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const text = fields.find(f => f.type === 'text')!;
+      expect(() => form.setChoices(text.fullName, ['x'])).toThrow();
+
+      const choice = fields.find(f => f.type === 'choice' && f.options.length > 0 && !f.readOnly);
+      if (!choice) return;
+
+      const last = choice.options[choice.options.length - 1];
+      form.setChoices(choice.fullName, [last]);
+      expect(form.getField(choice.fullName)?.value).toBe(last);
+      form.setField(choice.fullName, choice.options[0]);
+      expect(form.getField(choice.fullName)?.value).toBe(choice.options[0]);
+      expect(() => form.setChoices(choice.fullName, ['not an option'])).toThrow();
+    });
+
+    it('should apply a batch with per-field statuses', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const [a, b] = form.getFields().filter(f => f.type === 'text' && !f.readOnly);
+      const values = { [a.fullName]: 'Batch A', 'no.such.field': 'x', [b.fullName]: 'Batch B' };
+
+      const atomic = form.applyFields(values, { atomic: true });
+      expect(atomic.map(r => r.status)).toEqual(['not-applied', 'not-found', 'not-applied']);
+      expect(form.getField(a.fullName)?.value).toBe(a.value);
+
+      const partial = form.applyFields(values);
+      expect(partial.map(r => r.status)).toEqual(['ok', 'not-found', 'ok']);
+      expect(partial[1].name).toBe('no.such.field');
+      expect(form.getField(a.fullName)?.value).toBe('Batch A');
+      expect(form.getField(b.fullName)?.value).toBe('Batch B');
+      expect(form.lastError).toContain('no.such.field');
+    });
+
+    it('should apply typed values by field type', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const text = fields.find(f => f.type === 'text' && !f.readOnly)!;
+      const checkbox = fields.find(f => f.type === 'checkbox' && !f.readOnly)!;
+
+      const results = form.applyFields({
+        [text.fullName]: 42.5,
+        [checkbox.fullName]: true,
+        'no.such.field': false,
+      });
+      expect(results.map(r => r.status)).toEqual(['ok', 'ok', 'not-found']);
+      expect(form.getField(text.fullName)?.value).toBe('42.5');
+      expect(form.getField(checkbox.fullName)?.isChecked).toBe(true);
+
+      expect(form.applyFields({ [text.fullName]: true })[0].status).toBe('type-mismatch');
+      expect(form.applyFields({ [text.fullName]: NaN })[0].status).toBe('invalid-value');
+
+      form.setFields({ [checkbox.fullName]: false });
+      expect(form.getField(checkbox.fullName)?.isChecked).toBe(false);
+    });
+
+    it('should round-trip non-ASCII names and values through a batch', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const [a, b] = form.getFields().filter(f => f.type === 'text' && !f.readOnly);
+      const values = { [a.fullName]: 'Zoë – 日本語 🙂', 'nö.such.fïeld': '', [b.fullName]: '' };
+
+      const results = form.applyFields(values);
+      expect(results.map(r => r.status)).toEqual(['ok', 'not-found', 'ok']);
+      expect(form.lastError).toContain('nö.such.fïeld');
+      expect(form.getField(a.fullName)?.value).toBe('Zoë – 日本語 🙂');
+      expect(form.getField(b.fullName)?.value).toBe('');
+      expect(form.applyFields({})).toEqual([]);
+    });
+
+    it('should select a radio button by export value', async () => {
+      const { data, exportValues } = makeFormPdf(1);
+      const form = await PdfForm.fromUint8Array(data);
+
+      expect(form.applyFields({ choice: 'large' })[0]?.status).toBe('ok');
+      expect(form.applyFields({ choice: 'medium' })[0]?.status).toBe('ok');
+      expect(form.getField('choice')?.value).toBe('medium');
+
+      // Only the selected widget is on after a reload
+      const saved = form.saveAsUint8Array({ mode: 'incremental' });
+      const reloaded = await PdfForm.fromUint8Array(saved);
+      expect(reloaded.getField('choice')?.value).toBe('medium');
+      expect(radioAppearanceStates(saved, exportValues)).toEqual({ small: 'Off', medium: 'medium', large: 'Off' });
+    });
+
+    it('should reject a radio value that matches no export value', async () => {
+      const form = await PdfForm.fromUint8Array(makeFormPdf(1).data);
+      form.applyFields({ choice: 'small' });
+
+      const results = form.applyFields({ choice: 'bogus' });
+      expect(results[0]?.status).toBe('invalid-value');
+      expect(form.getField('choice')?.value).toBe('small');
+      expect(() => form.setField('choice', 'bogus')).toThrow();
+    });
+
+    it('should query, set and reset a name subtree', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const field = fields.find(f => f.type === 'text' && !f.readOnly && f.fullName.includes('.'))!;
+      const prefix = field.fullName.slice(0, field.fullName.lastIndexOf('.'));
+
+      const expected = fields
+        .filter(f => f.fullName === prefix || f.fullName.startsWith(prefix + '.'))
+        .map(f => f.fullName)
+        .sort();
+      expect(form.getFieldsUnder(prefix).map(f => f.fullName)).toEqual(expected);
+      expect(form.getFieldsUnder('').length).toBe(fields.length);
+
+      const relative = field.fullName.slice(prefix.length + 1);
+      form.setFieldsUnder(prefix, { [relative]: 'Subtree value' });
+      expect(form.getField(field.fullName)?.value).toBe('Subtree value');
+
+      form.resetFieldsUnder(prefix);
+      expect(form.getField(field.fullName)?.value).toBe(field.defaultValue);
+      expect(() => form.resetFieldsUnder('no.such.prefix')).toThrow();
+    });
+
+    it('should reflect each set in the field list without a full reload', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const textFields = fields.filter(f => f.type === 'text' && !f.readOnly).slice(0, 10);
+      const checkbox = fields.find(f => f.type === 'checkbox');
+
+      textFields.forEach((f, i) => form.setField(f.fullName, `Value ${i}`));
+      form.setCheckbox(checkbox!.fullName, true);
+
+      const updated = form.getFields();
+      expect(updated.length).toBe(fields.length);
+      textFields.forEach((f, i) => {
+        expect(updated.find(u => u.fullName === f.fullName)?.value).toBe(`Value ${i}`);
+      });
+      expect(form.getField(checkbox!.fullName)?.isChecked).toBe(true);
+    });
+
     it('should set a checkbox without throwing', async () => {
       const data = fs.readFileSync(testPdfPath);
       const form = await PdfForm.fromUint8Array(data);
@@ -95,6 +571,97 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
     });
   });
 
+  describe.skipIf(!testPdfExists)('forking', () => {
+    it('should fill a fork without touching the template', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const template = await PdfForm.fromUint8Array(data);
+
+      const textField = template.getFields().find(f => f.type === 'text');
+      expect(textField).toBeDefined();
+      const originalValue = textField!.value;
+
+      const copy = template.fork();
+      copy.setField(textField!.fullName, 'Forked Value');
+
+      expect(copy.getField(textField!.fullName)?.value).toBe('Forked Value');
+      expect(template.getField(textField!.fullName)?.value).toBe(originalValue);
+
+      const saved = copy.saveAsUint8Array();
+      const reloaded = await PdfForm.fromUint8Array(saved);
+      expect(reloaded.getField(textField!.fullName)?.value).toBe('Forked Value');
+
+      copy.dispose();
+      reloaded.dispose();
+      template.dispose();
+    });
+
+    it('should load the rest of a partially loaded table in a fork', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const expected = (await PdfForm.fromUint8Array(data)).getFields();
+
+      const template = await PdfForm.fromUint8Array(data);
+      template.getFields(['names']);
+      const copy = template.fork();
+
+      expect(copy.getFields()).toEqual(expected);
+      expect(template.getFields()).toEqual(expected);
+    });
+  });
+
+  describe.skipIf(!testPdfExists)('compiled templates', () => {
+    it('should reproduce the field table from a compiled template', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const source = await PdfForm.fromUint8Array(data);
+      const blob = source.compileTemplate();
+      const expected = source.getFields();
+
+      const form = await PdfForm.fromUint8Array(data);
+      form.loadTemplate(blob);
+      expect(form.getFields()).toEqual(expected);
+
+      // Lookups through the template still reach the Poppler fields
+      const textField = expected.find(f => f.type === 'text')!;
+      form.setField(textField.fullName, 'From Template');
+      const reloaded = await PdfForm.fromUint8Array(form.saveAsUint8Array());
+      expect(reloaded.getField(textField.fullName)?.value).toBe('From Template');
+    });
+
+    it('should reject a template compiled for another document', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const source = await PdfForm.fromUint8Array(data);
+      const blob = source.compileTemplate();
+
+      const other = await PdfForm.fromUint8Array(padPdf(new Uint8Array(data), data.length + 4096));
+      expect(() => other.loadTemplate(blob)).toThrow(/does not match/);
+      expect(() => other.loadTemplate(new Uint8Array([1, 2, 3]))).toThrow();
+    });
+
+    it('should reject a template for a modified document or with a bad field type', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const source = await PdfForm.fromUint8Array(data);
+      const blob = source.compileTemplate();
+
+      const modified = await PdfForm.fromUint8Array(data);
+      const text = modified.getFields().find(f => f.type === 'text' && !f.readOnly)!;
+      modified.setField(text.fullName, 'Edited');
+      expect(() => modified.loadTemplate(blob)).toThrow(/modified/);
+      expect(modified.getField(text.fullName)?.value).toBe('Edited');
+
+      // Magic, version, fingerprint, count, then the first field's ref and four strings
+      const corrupt = blob.slice();
+      const view = new DataView(corrupt.buffer);
+      let pos = 8;
+      pos += 4 + view.getUint32(pos, true) + 4 + 8;
+      for (let i = 0; i < 4; i++) pos += 4 + view.getUint32(pos, true);
+      corrupt[pos] = 200;
+
+      const target = await PdfForm.fromUint8Array(data);
+      expect(() => target.loadTemplate(corrupt)).toThrow(/field type/);
+      target.loadTemplate(blob);
+      expect(target.getFields()).toEqual(source.getFields());
+    });
+  });
+
   describe.skipIf(!testPdfExists)('saving', () => {
     it('should save unmodified PDF', async () => {
       const data = fs.readFileSync(testPdfPath);
@@ -108,6 +675,16 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       expect(header).toBe('%PDF-');
     });
 
+    it('should copy an unmodified PDF on auto but re-serialize it on rewrite', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      expect(Buffer.from(form.saveAsUint8Array()).equals(data)).toBe(true);
+      const rewritten = form.saveAsUint8Array({ mode: 'rewrite' });
+      expect(Buffer.from(rewritten).equals(data)).toBe(false);
+      expect((await PdfForm.fromUint8Array(rewritten)).getFields().length).toBe(form.getFields().length);
+    });
+
     it('should save PDF after setting text field', async () => {
       const data = fs.readFileSync(testPdfPath);
       const form = await PdfForm.fromUint8Array(data);
@@ -126,6 +703,80 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
       expect(header).toBe('%PDF-');
     });
 
+    it('should round-trip ASCII, Latin-1 and non-Latin text values', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      // PDFDocEncoding, PDFDocEncoding with non-ASCII, UTF-16 (CJK, surrogate pair),
+      // an odd-length ASCII value, and values whose PDFDocEncoding bytes would
+      // look like a UTF-16BE, UTF-16LE or UTF-8 byte order mark
+      const values = ['123 Main Street, Springfield', 'Zürich – 5 €', '東京都 😀', 'Bob', 'þÿ', 'ÿþ', 'ï»x'];
+      const textFields = form.getFields().filter(f => f.type === 'text' && !f.readOnly).slice(0, values.length);
+      textFields.forEach((f, i) => form.setField(f.fullName, values[i]));
+
+      const reloaded = await PdfForm.fromUint8Array(form.saveAsUint8Array());
+      textFields.forEach((f, i) => {
+        expect(reloaded.getField(f.fullName)?.value).toBe(values[i]);
+      });
+    });
+
+    it('should append an incremental update after the original bytes', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const fields = form.getFields();
+      const textField = fields.find(f => f.type === 'text');
+      expect(textField).toBeDefined();
+
+      form.setField(textField!.fullName, 'Test Value');
+
+      const saved = form.saveAsUint8Array({ mode: 'incremental' });
+      expect(saved.length).toBeGreaterThan(data.length);
+      expect(Buffer.from(saved.subarray(0, data.length)).equals(data)).toBe(true);
+
+      // The update must be readable
+      const reloaded = await PdfForm.fromUint8Array(saved);
+      expect(reloaded.getField(textField!.fullName)?.value).toBe('Test Value');
+    });
+
+    it('should stream the same bytes as save()', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const chunks: Uint8Array[] = [];
+      form.saveToStream(chunk => {
+        chunks.push(chunk);
+      });
+
+      expect(Buffer.concat(chunks).equals(Buffer.from(form.saveAsUint8Array()))).toBe(true);
+    });
+
+    it('should write the same bytes into a slow WritableStream', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      const received: Uint8Array[] = [];
+      const stream = new WritableStream<Uint8Array>(
+        {
+          async write(chunk) {
+            await new Promise(resolve => setTimeout(resolve, 1));
+            received.push(chunk);
+          },
+        },
+        new CountQueuingStrategy({ highWaterMark: 1 })
+      );
+      await form.saveToWritable(stream);
+
+      expect(Buffer.concat(received).equals(Buffer.from(form.saveAsUint8Array()))).toBe(true);
+    });
+
+    it('should report an aborted stream', async () => {
+      const data = fs.readFileSync(testPdfPath);
+      const form = await PdfForm.fromUint8Array(data);
+
+      expect(() => form.saveToStream(() => false)).toThrow(/aborted/);
+    });
+
     it('should save PDF after setting checkbox', async () => {
       const data = fs.readFileSync(testPdfPath);
       const form = await PdfForm.fromUint8Array(data);
@@ -174,3 +825,13 @@ describe.skipIf(!wasmExists)('PdfForm', () => {
     });
   });
 });
+
+describe('packed field values', () => {
+  it('should throw instead of writing at address 0 when _malloc fails', () => {
+    const module = { _malloc: () => 0, _free: () => {}, HEAPU8: new Uint8Array(64) } as unknown as PdfFillerModule;
+    let called = false;
+    expect(() => withPackedFieldValues(module, { name: 'value' }, () => (called = true))).toThrow(/allocate/);
+    expect(called).toBe(false);
+    expect(Array.from(module.HEAPU8).every(b => b === 0)).toBe(true);
+  });
+});